@@ -1,15 +1,28 @@
 const int NUM_SLIDERS = 5;
 const int analogInputs[NUM_SLIDERS] = {12, 13, 15, 2, 4};
 int analogSliderValues[NUM_SLIDERS];
+int lastSentValues[NUM_SLIDERS];
 
-const char *HANDSHAKE_KEY = "AUDIOMIXER_HELLO";
+// " V2" offers the binary protocol, a host that only answers READY keeps us on text.
+const char *HANDSHAKE_KEY = "AUDIOMIXER_HELLO V2";
 const char *HANDSHAKE_RESPONSE = "AUDIOMIXER_READY";
+const char *HANDSHAKE_RESPONSE_V2 = "AUDIOMIXER_READY V2";
 const char *HEARTBEAT = "AUDIOMIXER_V1_HEARTBEAT";
 
 const unsigned long handshakeRetryInterval = 1000; // ms
 const unsigned long handshakeTimeout = 10000;      // ms
 const unsigned long heartbeatInterval = 500;       // ms
 const unsigned long heartbeatTimeout = 1500;       // ms
+const unsigned long textSampleInterval = 100;      // ms
+const unsigned long binarySampleInterval = 5;      // ms, 200 Hz
+const unsigned long keyframeInterval = 1000;       // ms, full state so the host can resync
+const int deadBand = 8;                            // 12-bit steps a slider must move to be reported
+
+// Binary protocol v2: COBS framed [type][sequence][body][crc16 le], 0x00 terminated
+const uint8_t PACKET_FULL = 0x01;
+const uint8_t PACKET_HEARTBEAT = 0x02;
+const uint8_t PACKET_DELTA = 0x03;
+const size_t PACKET_MAX_SIZE = 128;
 
 enum State
 {
@@ -17,11 +30,15 @@ enum State
     DATA
 };
 State state = HANDSHAKE;
+bool binaryProtocol = false;
+uint8_t sequence = 0;
 
 unsigned long lastHandshakeSent = 0;
 unsigned long handshakeStart = 0;
 unsigned long lastHeartbeatSent = 0;
 unsigned long lastHeartbeatAck = 0;
+unsigned long lastSampleSent = 0;
+unsigned long lastKeyframeSent = 0;
 
 void setup()
 {
@@ -46,10 +63,16 @@ void loop()
         {
             String input = Serial.readStringUntil('\n');
             input.trim();
-            if (input == HANDSHAKE_RESPONSE)
+            if (input == HANDSHAKE_RESPONSE || input == HANDSHAKE_RESPONSE_V2)
             {
+                binaryProtocol = (input == HANDSHAKE_RESPONSE_V2);
+                if (binaryProtocol)
+                {
+                    Serial.write((uint8_t)0); // Resync the host's packet framing
+                }
                 state = DATA;
                 lastHeartbeatAck = millis();
+                lastKeyframeSent = millis() - keyframeInterval; // Start with a keyframe
                 break;
             }
         }
@@ -61,13 +84,56 @@ void loop()
         break;
 
     case DATA:
-        updateSliderValues();
-        sendSliderValues();
+        if (millis() - lastSampleSent >= (binaryProtocol ? binarySampleInterval : textSampleInterval))
+        {
+            lastSampleSent = millis();
+            updateSliderValues();
+
+            // Only report sliders that moved, plus a periodic keyframe of everything
+            if (millis() - lastKeyframeSent >= keyframeInterval)
+            {
+                lastKeyframeSent = millis();
+                if (binaryProtocol)
+                {
+                    sendSliderPacket();
+                }
+                else
+                {
+                    sendSliderValues();
+                }
+                markSent(0xFFFFFFFFUL);
+            }
+            else
+            {
+                uint32_t changed = changedSliders();
+                if (changed != 0)
+                {
+                    if (binaryProtocol)
+                    {
+                        sendDeltaPacket(changed);
+                        markSent(changed);
+                    }
+                    else
+                    {
+                        // The text protocol has no delta form, send the full line
+                        sendSliderValues();
+                        markSent(0xFFFFFFFFUL);
+                    }
+                }
+            }
+        }
 
         // Send heartbeat if interval elapsed
         if (millis() - lastHeartbeatSent > heartbeatInterval)
         {
-            Serial.println(HEARTBEAT);
+            if (binaryProtocol)
+            {
+                sendHeartbeatPacket();
+            }
+            else
+            {
+                Serial.println(HEARTBEAT);
+            }
             lastHeartbeatSent = millis();
         }
 
@@ -88,8 +154,6 @@ void loop()
             state = HANDSHAKE;
             handshakeStart = millis();
         }
-
-        delay(100);
         break;
     }
 }
@@ -98,7 +162,34 @@ void updateSliderValues()
 {
     for (int i = 0; i < NUM_SLIDERS; i++)
     {
-        analogSliderValues[i] = map(analogRead(analogInputs[i]), 0, 4095, 0, 1023);
+        analogSliderValues[i] = analogRead(analogInputs[i]); // 12-bit, 0-4095
+    }
+}
+
+// Bitmask of sliders that moved past the dead-band since they were last sent
+uint32_t changedSliders()
+{
+    uint32_t changed = 0;
+    for (int i = 0; i < NUM_SLIDERS; i++)
+    {
+        int value = analogSliderValues[i];
+        bool endStop = (value == 0 || value == 4095) && value != lastSentValues[i];
+        if (abs(value - lastSentValues[i]) > deadBand || endStop)
+        {
+            changed |= 1UL << i;
+        }
+    }
+    return changed;
+}
+
+void markSent(uint32_t sliders)
+{
+    for (int i = 0; i < NUM_SLIDERS; i++)
+    {
+        if (sliders & (1UL << i))
+        {
+            lastSentValues[i] = analogSliderValues[i];
+        }
     }
 }
 
@@ -107,7 +198,8 @@ void sendSliderValues()
     String builtString = "";
     for (int i = 0; i < NUM_SLIDERS; i++)
     {
-        builtString += String((int)analogSliderValues[i]);
+        // The text protocol carries 10-bit values
+        builtString += String((int)map(analogSliderValues[i], 0, 4095, 0, 1023));
         if (i < NUM_SLIDERS - 1)
         {
             builtString += "|";
@@ -115,3 +207,126 @@ void sendSliderValues()
     }
     Serial.println(builtString);
 }
+
+uint16_t crc16(const uint8_t *data, size_t length)
+{
+    // CRC-16/CCITT-FALSE
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+size_t cobsEncode(const uint8_t *in, size_t length, uint8_t *out)
+{
+    size_t read = 0;
+    size_t write = 1;
+    size_t codePos = 0;
+    uint8_t code = 1;
+    while (read < length)
+    {
+        if (in[read] == 0)
+        {
+            out[codePos] = code;
+            code = 1;
+            codePos = write++;
+            read++;
+        }
+        else
+        {
+            out[write++] = in[read++];
+            if (++code == 0xFF)
+            {
+                out[codePos] = code;
+                code = 1;
+                codePos = write++;
+            }
+        }
+    }
+    out[codePos] = code;
+    return write;
+}
+
+// Append the CRC, COBS encode and write the packet with its 0x00 delimiter
+void sendPacket(uint8_t *packet, size_t length)
+{
+    uint16_t crc = crc16(packet, length);
+    packet[length++] = crc & 0xFF;
+    packet[length++] = crc >> 8;
+
+    uint8_t encoded[PACKET_MAX_SIZE + PACKET_MAX_SIZE / 254 + 2];
+    size_t encodedLength = cobsEncode(packet, length, encoded);
+    encoded[encodedLength++] = 0;
+    Serial.write(encoded, encodedLength);
+}
+
+// Pack 12-bit values two per three bytes, returns the number of bytes written
+size_t packValues(const int *values, int count, uint8_t *out)
+{
+    size_t length = 0;
+    for (int i = 0; i < count; i += 2)
+    {
+        uint16_t a = values[i] & 0x0FFF;
+        uint16_t b = (i + 1 < count) ? (values[i + 1] & 0x0FFF) : 0;
+        out[length++] = a & 0xFF;
+        out[length++] = (a >> 8) | ((b & 0x0F) << 4);
+        if (i + 1 < count)
+        {
+            out[length++] = b >> 4;
+        }
+    }
+    return length;
+}
+
+void sendSliderPacket()
+{
+    uint8_t packet[PACKET_MAX_SIZE];
+    size_t length = 0;
+    packet[length++] = PACKET_FULL;
+    packet[length++] = sequence++;
+    packet[length++] = NUM_SLIDERS;
+    length += packValues(analogSliderValues, NUM_SLIDERS, packet + length);
+    sendPacket(packet, length);
+}
+
+void sendDeltaPacket(uint32_t changed)
+{
+    uint8_t packet[PACKET_MAX_SIZE];
+    size_t length = 0;
+    packet[length++] = PACKET_DELTA;
+    packet[length++] = sequence++;
+    packet[length++] = NUM_SLIDERS;
+
+    // Changed bitmask, LSB first
+    for (int i = 0; i < NUM_SLIDERS; i += 8)
+    {
+        packet[length++] = (changed >> i) & 0xFF;
+    }
+
+    int values[NUM_SLIDERS];
+    int count = 0;
+    for (int i = 0; i < NUM_SLIDERS; i++)
+    {
+        if (changed & (1UL << i))
+        {
+            values[count++] = analogSliderValues[i];
+        }
+    }
+    length += packValues(values, count, packet + length);
+    sendPacket(packet, length);
+}
+
+void sendHeartbeatPacket()
+{
+    uint8_t packet[PACKET_MAX_SIZE];
+    size_t length = 0;
+    packet[length++] = PACKET_HEARTBEAT;
+    packet[length++] = sequence++;
+    sendPacket(packet, length);
+}
@@ -0,0 +1,117 @@
+// Micro-benchmark: single-pass frame parser vs. the previous regex + extract path.
+//
+// Usage: frame_parser_bench [iterations]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "frame_parser.hpp"
+
+namespace
+{
+    constexpr uint16_t NUM_OF_KNOBS = 5;
+    constexpr size_t NUM_OF_LINES = 1024;
+
+    // The validation pattern previously built by audio_mixer_c::create_regex.
+    std::regex legacy_create_regex(uint16_t count)
+    {
+        std::string numberPattern = "(?:[0-9]{1,4})";
+
+        std::string fullPattern = "^" + numberPattern;
+        for (int i = 1; i < count; ++i)
+        {
+            fullPattern += "\\|" + numberPattern;
+        }
+        fullPattern += "$";
+
+        return std::regex(fullPattern);
+    }
+
+    // The decoder previously implemented by audio_mixer_c::extract_values.
+    std::vector<int> legacy_extract_values(std::string &values)
+    {
+        std::vector<int> result;
+        size_t pos = 0;
+        std::string token;
+        while ((pos = values.find('|')) != std::string::npos)
+        {
+            token = values.substr(0, pos);
+            result.emplace_back(std::atoi(token.c_str()));
+            values.erase(0, pos + 1);
+        }
+        result.emplace_back(std::atoi(values.c_str()));
+        return result;
+    }
+
+    std::vector<std::string> make_lines()
+    {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> dist(0, 1023);
+        std::vector<std::string> lines;
+        lines.reserve(NUM_OF_LINES);
+        for (size_t i = 0; i < NUM_OF_LINES; i++)
+        {
+            std::string line;
+            for (uint16_t k = 0; k < NUM_OF_KNOBS; k++)
+            {
+                if (k != 0)
+                {
+                    line += "|";
+                }
+                line += std::to_string(dist(rng));
+            }
+            lines.emplace_back(line);
+        }
+        return lines;
+    }
+
+    template <typename Fn>
+    double time_ns_per_frame(size_t iterations, Fn &&fn)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            fn(i % NUM_OF_LINES);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t const iterations = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    auto const lines = make_lines();
+    volatile uint64_t sink = 0;
+
+    std::regex const pattern = legacy_create_regex(NUM_OF_KNOBS);
+    double legacy_ns = time_ns_per_frame(iterations, [&](size_t i) {
+        // get_latest_match copied the line out of the stack before matching.
+        std::string line = lines[i];
+        if (std::regex_match(line, pattern))
+        {
+            auto vals = legacy_extract_values(line);
+            sink = sink + static_cast<uint64_t>(vals.back());
+        }
+    });
+
+    audio_mixer::knob_frame frame;
+    double parser_ns = time_ns_per_frame(iterations, [&](size_t i) {
+        if (audio_mixer::parse_frame(lines[i], NUM_OF_KNOBS, frame))
+        {
+            sink = sink + frame.values[NUM_OF_KNOBS - 1];
+        }
+    });
+
+    std::printf("frames:               %zu x %u knobs\n", iterations, static_cast<unsigned>(NUM_OF_KNOBS));
+    std::printf("regex + extract:      %8.1f ns/frame\n", legacy_ns);
+    std::printf("parse_frame:          %8.1f ns/frame\n", parser_ns);
+    std::printf("speedup:              %8.1fx\n", legacy_ns / parser_ns);
+    return sink == 0 ? 1 : 0;
+}
@@ -0,0 +1,77 @@
+// Micro-benchmark: knob filter bank (median-of-N + One-Euro) cost per frame.
+//
+// Usage: knob_filter_bench [iterations] [median]
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "knob_filter.hpp"
+
+namespace
+{
+    constexpr size_t NUM_OF_FRAMES = 1024;
+    constexpr uint64_t FRAME_INTERVAL_NS = 2000000; // 500 Hz
+
+    // Slowly turning knobs with +-3 LSB of ADC noise, 12-bit
+    std::vector<audio_mixer::knob_frame> make_frames(uint16_t knobs)
+    {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> noise(-3, 3);
+        std::vector<audio_mixer::knob_frame> frames(NUM_OF_FRAMES);
+        for (size_t i = 0; i < NUM_OF_FRAMES; i++)
+        {
+            auto &frame = frames[i];
+            frame.count = knobs;
+            frame.bits = 12;
+            frame.received_ns = (i + 1) * FRAME_INTERVAL_NS;
+            for (uint16_t k = 0; k < knobs; k++)
+            {
+                double const position = 2047.0 + 1800.0 * std::sin(0.01 * static_cast<double>(i) + k);
+                frame.values[k] = static_cast<uint16_t>(std::lround(position) + noise(rng));
+            }
+        }
+        return frames;
+    }
+
+    double time_ns_per_frame(size_t iterations, uint16_t knobs, size_t median, volatile float &sink)
+    {
+        auto frames = make_frames(knobs);
+        audio_mixer::knob_filter_c filter;
+        filter.configure(median, 1.0f, 10.0f);
+        std::array<float, AUDIO_MIXER_MAX_KNOBS> output{};
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            // Keep the sample clock monotonic across passes over the frames
+            auto &frame = frames[i % NUM_OF_FRAMES];
+            frame.received_ns = (i + 1) * FRAME_INTERVAL_NS;
+            filter.apply(frame, output);
+            sink = sink + output[knobs - 1];
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t const iterations = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t const median = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 3;
+    volatile float sink = 0.0f;
+
+    std::printf("frames:               %zu, median of %zu + One-Euro\n", iterations, median);
+    for (uint16_t knobs : {5, 16, 64})
+    {
+        double const ns = time_ns_per_frame(iterations, knobs, median, sink);
+        std::printf("%2u knobs:             %8.1f ns/frame  %6.2f ns/knob\n", static_cast<unsigned>(knobs), ns,
+                    ns / knobs);
+    }
+    return sink == 0.0f ? 1 : 0;
+}
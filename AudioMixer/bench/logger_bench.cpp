@@ -0,0 +1,140 @@
+// Micro-benchmark: logger throughput and caller-side cost, synchronous vs. async writer.
+//
+// Usage: logger_bench [messages] [threads]
+//
+// Every thread logs a typical per-frame DEBUG line as fast as it can. Caller cost
+// is the time spent inside log_debug(); throughput counts messages that reached
+// the file, including the time the async writer needs to drain its ring. The
+// last two lines compare a DEBUG line that is filtered out at run time, built by
+// string concatenation vs. passed to AUDIO_MIXER_LOG_DEBUG.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.hpp"
+
+namespace
+{
+    struct result
+    {
+        double messages_per_second;
+        double mean_ns;
+        uint64_t p50_ns;
+        uint64_t p99_ns;
+        uint64_t max_ns;
+        uint64_t dropped;
+    };
+
+    result run(bool async, size_t messages, size_t threads, std::string const &path)
+    {
+        auto &logger = audio_mixer::logger_c::instance();
+        std::filesystem::remove(path);
+        logger.set_file(path);
+        logger.set_log_level(audio_mixer::logger_c::LogLevel::DEBUG);
+        uint64_t const dropped_before = logger.dropped_count();
+        logger.set_async(async);
+
+        std::string const line = "Data received from serial port: /dev/ttyACM0 - 512|1023|0|77|4095";
+        size_t const per_thread = messages / threads;
+        std::vector<std::vector<uint32_t>> samples(threads);
+
+        auto const start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; t++)
+        {
+            workers.emplace_back([&, t]() {
+                auto &own = samples[t];
+                own.reserve(per_thread);
+                for (size_t i = 0; i < per_thread; i++)
+                {
+                    auto const before = std::chrono::steady_clock::now();
+                    audio_mixer::log_debug(line);
+                    auto const after = std::chrono::steady_clock::now();
+                    own.push_back(static_cast<uint32_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count()));
+                }
+            });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        // Turning async mode off writes what is still queued
+        logger.set_async(false);
+        auto const elapsed = std::chrono::steady_clock::now() - start;
+
+        std::vector<uint32_t> all;
+        for (auto &own : samples)
+        {
+            all.insert(all.end(), own.begin(), own.end());
+        }
+        std::sort(all.begin(), all.end());
+        uint64_t total_ns = 0;
+        for (uint32_t ns : all)
+        {
+            total_ns += ns;
+        }
+
+        result r;
+        r.dropped = logger.dropped_count() - dropped_before;
+        r.messages_per_second = static_cast<double>(all.size() - r.dropped) / std::chrono::duration<double>(elapsed).count();
+        r.mean_ns = static_cast<double>(total_ns) / static_cast<double>(all.size());
+        r.p50_ns = all[all.size() / 2];
+        r.p99_ns = all[all.size() * 99 / 100];
+        r.max_ns = all.back();
+        return r;
+    }
+
+    // Caller cost of a per-frame DEBUG line while the level is INFO
+    template <typename LOG>
+    double filtered_ns(size_t messages, LOG log)
+    {
+        std::string const port = "/dev/ttyACM0";
+        std::string const line = "512|1023|0|77|4095";
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < messages; i++)
+        {
+            log(port, line);
+        }
+        auto const elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(messages);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t const messages = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    size_t const threads = std::max<size_t>((argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 2, 1);
+    std::string const path = (std::filesystem::temp_directory_path() / "logger_bench.log").string();
+
+    std::printf("messages:             %zu from %zu threads\n", messages, threads);
+    for (bool async : {false, true})
+    {
+        result const r = run(async, messages, threads, path);
+        std::printf("%-6s written:       %10.0f msg/s, dropped %llu\n", async ? "async" : "sync", r.messages_per_second,
+                    static_cast<unsigned long long>(r.dropped));
+        std::printf("%-6s caller:        mean %7.1f ns  p50 %6llu ns  p99 %7llu ns  max %8llu ns\n",
+                    async ? "async" : "sync", r.mean_ns, static_cast<unsigned long long>(r.p50_ns),
+                    static_cast<unsigned long long>(r.p99_ns), static_cast<unsigned long long>(r.max_ns));
+    }
+
+    audio_mixer::logger_c::instance().set_log_level(audio_mixer::logger_c::LogLevel::INFO);
+    double const concatenated = filtered_ns(messages, [](std::string const &port, std::string const &line) {
+        audio_mixer::log_debug("Data received from serial port: " + port + " - " + line);
+    });
+    double const deferred = filtered_ns(messages, [](std::string const &port, std::string const &line) {
+        AUDIO_MIXER_LOG_DEBUG("Data received from serial port: ", port, " - ", line);
+    });
+    std::printf("filtered, concatenated: %7.1f ns\n", concatenated);
+    std::printf("filtered, macro:        %7.1f ns\n", deferred);
+
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,507 @@
+// Benchmark: end-to-end latency of the serial -> mailbox -> mixer pipeline (Linux).
+//
+// A simulated controller drives a pseudo-terminal the way the firmware does:
+// handshake, heartbeats and knob frames at a fixed rate with optional jitter,
+// in either the text protocol or binary protocol v2. The real serial
+// connection and mixer consume it, and an injected media backend records when
+// each volume lands. Knob 0 carries a frame marker, so every master volume
+// apply can be matched with the moment its frame was written.
+//
+// Usage: pipeline_latency_bench [--protocol text|v2] [--rate hz] [--knobs n]
+//                               [--jitter-us us] [--seconds s] [--min-interval-ms ms]
+//                               [--endpoint-interval-ms ms]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "audio_mixer.hpp"
+#include "logger.hpp"
+#include "pipeline_latency.hpp"
+#include "protocol.hpp"
+#include "serial.hpp"
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    struct options
+    {
+        bool binary = true;
+        double rate_hz = 200.0;
+        uint16_t knobs = 5;
+        uint32_t jitter_us = 0;
+        double seconds = 5.0;
+        uint16_t min_interval_ms = 0;
+        uint16_t endpoint_interval_ms = 0;
+    };
+
+    int64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+    }
+
+    // Frame markers wrap at the protocol's value range, so a marker is unambiguous
+    // as long as a frame is applied within (range / rate) seconds.
+    class marker_log_c
+    {
+    public:
+        explicit marker_log_c(uint16_t range)
+            : m_range(range),
+              m_sent(range)
+        {
+            for (auto &slot : m_sent)
+            {
+                slot.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        uint16_t range() const { return m_range; }
+
+        void record_send(uint16_t marker) { m_sent[marker].store(now_ns(), std::memory_order_release); }
+
+        int64_t sent_at(uint16_t marker) const { return m_sent[marker].load(std::memory_order_acquire); }
+
+    private:
+        uint16_t m_range;
+        std::vector<std::atomic<int64_t>> m_sent;
+    };
+
+    // Media backend that only records when the master volume was applied.
+    // Runs on the mixer's media worker thread.
+    class recording_media_interface_c : public audio_mixer::os_media_interface_c
+    {
+    public:
+        recording_media_interface_c(marker_log_c const &markers, uint16_t knobs)
+            : m_markers(markers)
+        {
+            for (uint16_t i = 1; i < knobs; i++)
+            {
+                m_sessions.emplace_back("bench_" + std::to_string(i));
+            }
+            m_latencies_us.reserve(1 << 20);
+        }
+
+        void initialize() override {}
+
+        void set_master_volume(float volume) override
+        {
+            int64_t const applied = now_ns();
+            auto marker = static_cast<uint16_t>(std::lround(volume * static_cast<float>(m_markers.range() - 1)));
+            int64_t const sent = m_markers.sent_at(marker);
+            if (sent != 0 && m_recording.load(std::memory_order_relaxed))
+            {
+                m_latencies_us.emplace_back(static_cast<double>(applied - sent) / 1000.0);
+            }
+            ++m_applied;
+        }
+
+        std::vector<audio_mixer::endpoint> get_endpoints() override { return m_sessions; }
+
+        bool set_application_volume(audio_mixer::endpoint const &) override { return true; }
+
+        void set_microphone_volume(float) override {}
+
+        void start_recording() { m_recording = true; }
+        void stop_recording() { m_recording = false; }
+
+        // Only read once recording has stopped and the last frames have landed
+        std::vector<double> const &latencies_us() const { return m_latencies_us; }
+        uint64_t applied() const { return m_applied.load(); }
+
+    private:
+        marker_log_c const &m_markers;
+        std::vector<audio_mixer::endpoint> m_sessions;
+        std::vector<double> m_latencies_us;
+        std::atomic<bool> m_recording{false};
+        std::atomic<uint64_t> m_applied{0};
+    };
+
+    // Encoder side of protocol v2, mirrors the firmware.
+    size_t cobs_encode(uint8_t const *in, size_t length, uint8_t *out)
+    {
+        size_t code_index = 0;
+        size_t written = 1;
+        uint8_t code = 1;
+        for (size_t i = 0; i < length; i++)
+        {
+            if (in[i] == 0)
+            {
+                out[code_index] = code;
+                code_index = written++;
+                code = 1;
+                continue;
+            }
+            out[written++] = in[i];
+            if (++code == 0xFF)
+            {
+                out[code_index] = code;
+                code_index = written++;
+                code = 1;
+            }
+        }
+        out[code_index] = code;
+        return written;
+    }
+
+    std::string encode_packet(audio_mixer::PacketType type, uint8_t sequence, std::vector<uint16_t> const &values)
+    {
+        uint8_t packet[AUDIO_MIXER_PACKET_MAX_SIZE] = {};
+        size_t length = 0;
+        packet[length++] = static_cast<uint8_t>(type);
+        packet[length++] = sequence;
+        if (type == audio_mixer::PacketType::FULL)
+        {
+            packet[length++] = static_cast<uint8_t>(values.size());
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                uint8_t *p = packet + length + (i * 12) / 8;
+                if (i % 2 == 0)
+                {
+                    p[0] = static_cast<uint8_t>(values[i] & 0xFF);
+                    p[1] = static_cast<uint8_t>((p[1] & 0xF0) | (values[i] >> 8));
+                }
+                else
+                {
+                    p[0] = static_cast<uint8_t>((p[0] & 0x0F) | ((values[i] & 0x0F) << 4));
+                    p[1] = static_cast<uint8_t>(values[i] >> 4);
+                }
+            }
+            length += (values.size() * 12 + 7) / 8;
+        }
+        uint16_t crc = audio_mixer::crc16_ccitt(packet, length);
+        packet[length++] = static_cast<uint8_t>(crc & 0xFF);
+        packet[length++] = static_cast<uint8_t>(crc >> 8);
+
+        uint8_t encoded[AUDIO_MIXER_PACKET_MAX_SIZE + 2];
+        size_t encoded_length = cobs_encode(packet, length, encoded);
+        encoded[encoded_length++] = 0;
+        return std::string(reinterpret_cast<char const *>(encoded), encoded_length);
+    }
+
+    void write_all(int fd, std::string const &data)
+    {
+        size_t offset = 0;
+        while (offset < data.size())
+        {
+            ssize_t n = write(fd, data.data() + offset, data.size() - offset);
+            if (n <= 0)
+            {
+                return;
+            }
+            offset += static_cast<size_t>(n);
+        }
+    }
+
+    // Reads whatever the host sent, returns it appended to input.
+    void drain(int fd, std::string &input, int timeout_ms)
+    {
+        pollfd pfd{fd, POLLIN, 0};
+        while (poll(&pfd, 1, timeout_ms) > 0 && (pfd.revents & POLLIN))
+        {
+            char buf[256];
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0)
+            {
+                return;
+            }
+            input.append(buf, static_cast<size_t>(n));
+            timeout_ms = 0;
+        }
+    }
+
+    struct controller_stats
+    {
+        uint64_t frames_sent = 0;
+        uint64_t measured_from = 0; // First frame after the warm-up
+        double send_seconds = 0;
+    };
+
+    // The simulated controller, runs until stop is set.
+    void run_controller(int fd, options const &opts, marker_log_c &markers, recording_media_interface_c &media,
+                        std::atomic<bool> &stop, controller_stats &stats)
+    {
+        // Handshake, repeated until the prober answers
+        std::string const hello = std::string(audio_mixer::HANDSHAKE_KEY) +
+                                  (opts.binary ? std::string(audio_mixer::PROTOCOL_V2) : std::string()) + "\r\n";
+        std::string input;
+        bool binary = false;
+        while (!stop)
+        {
+            write_all(fd, hello);
+            drain(fd, input, 200);
+            auto pos = input.find(audio_mixer::HANDSHAKE_RESPONSE);
+            if (pos != std::string::npos && input.find('\n', pos) != std::string::npos)
+            {
+                binary = input.find(std::string(audio_mixer::HANDSHAKE_RESPONSE) +
+                                    std::string(audio_mixer::PROTOCOL_V2), pos) != std::string::npos;
+                break;
+            }
+        }
+        if (binary)
+        {
+            write_all(fd, std::string(1, '\0')); // Resync the host's framer
+        }
+
+        std::mt19937 rng(11);
+        std::uniform_int_distribution<uint32_t> jitter(0, opts.jitter_us);
+        std::uniform_int_distribution<int> step(-8, 8);
+        uint16_t const max_value = static_cast<uint16_t>(markers.range() - 1);
+        std::vector<uint16_t> values(opts.knobs, max_value / 2);
+        uint8_t sequence = 0;
+
+        auto const period = std::chrono::duration<double>(1.0 / opts.rate_hz);
+        auto const heartbeat_period = std::chrono::milliseconds(250);
+        auto const warm_up = std::chrono::milliseconds(500);
+        auto const start = clock_type::now();
+        auto next_heartbeat = start;
+        bool recording = false;
+
+        while (!stop)
+        {
+            auto const scheduled = start + std::chrono::duration_cast<clock_type::duration>(period * stats.frames_sent);
+            std::this_thread::sleep_until(scheduled + std::chrono::microseconds(jitter(rng)));
+
+            if (!recording && clock_type::now() - start >= warm_up)
+            {
+                recording = true;
+                stats.measured_from = stats.frames_sent;
+                media.start_recording();
+            }
+
+            auto const now = clock_type::now();
+            if (now >= next_heartbeat)
+            {
+                write_all(fd, binary ? encode_packet(audio_mixer::PacketType::HEARTBEAT, sequence++, {})
+                                     : std::string(audio_mixer::HEARTBEAT) + "\r\n");
+                next_heartbeat = now + heartbeat_period;
+            }
+
+            // Knob 0 is the frame marker, the others wander like real hands on knobs
+            uint16_t const marker = static_cast<uint16_t>(stats.frames_sent % markers.range());
+            values[0] = marker;
+            for (size_t i = 1; i < values.size(); i++)
+            {
+                int v = static_cast<int>(values[i]) + step(rng);
+                values[i] = static_cast<uint16_t>(std::clamp(v, 0, static_cast<int>(max_value)));
+            }
+
+            std::string frame;
+            if (binary)
+            {
+                frame = encode_packet(audio_mixer::PacketType::FULL, sequence++, values);
+            }
+            else
+            {
+                for (size_t i = 0; i < values.size(); i++)
+                {
+                    frame += (i ? "|" : "") + std::to_string(values[i]);
+                }
+                frame += "\r\n";
+            }
+            markers.record_send(marker);
+            write_all(fd, frame);
+            ++stats.frames_sent;
+
+            input.clear();
+            drain(fd, input, 0); // Heartbeat echoes
+        }
+        media.stop_recording();
+        stats.send_seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    }
+
+    bool parse_options(int argc, char **argv, options &opts)
+    {
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            std::string const arg = argv[i];
+            std::string const value = argv[i + 1];
+            if (arg == "--protocol")
+            {
+                opts.binary = (value == "v2");
+            }
+            else if (arg == "--rate")
+            {
+                opts.rate_hz = std::strtod(value.c_str(), nullptr);
+            }
+            else if (arg == "--knobs")
+            {
+                opts.knobs = static_cast<uint16_t>(std::strtoul(value.c_str(), nullptr, 10));
+            }
+            else if (arg == "--jitter-us")
+            {
+                opts.jitter_us = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+            }
+            else if (arg == "--seconds")
+            {
+                opts.seconds = std::strtod(value.c_str(), nullptr);
+            }
+            else if (arg == "--min-interval-ms")
+            {
+                opts.min_interval_ms = static_cast<uint16_t>(std::strtoul(value.c_str(), nullptr, 10));
+            }
+            else if (arg == "--endpoint-interval-ms")
+            {
+                opts.endpoint_interval_ms = static_cast<uint16_t>(std::strtoul(value.c_str(), nullptr, 10));
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return (argc % 2) == 1 && opts.rate_hz > 0 && opts.seconds > 0 && opts.knobs >= 1 &&
+               opts.knobs <= AUDIO_MIXER_MAX_KNOBS;
+    }
+
+    std::string write_config(options const &opts)
+    {
+        char path[] = "/tmp/audiomixer_bench_XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0)
+        {
+            std::perror("mkstemp");
+            std::exit(1);
+        }
+        close(fd);
+
+        std::ofstream config(path);
+        config << "num_of_knobs: " << opts.knobs << "\n"
+               << "baud_rate: 115200\n"
+               << "update_mode: event\n"
+               << "min_update_interval_ms: " << opts.min_interval_ms << "\n"
+               << "dead_band: 0\n"
+               << "volume_step: 0\n"
+               << "endpoint_min_interval_ms: " << opts.endpoint_interval_ms << "\n"
+               << "endpoints:\n"
+               << "  - master\n";
+        for (uint16_t i = 1; i < opts.knobs; i++)
+        {
+            config << "  - bench_" << i << "\n";
+        }
+        return path;
+    }
+
+    double percentile(std::vector<double> const &sorted, double p)
+    {
+        size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    options opts;
+    if (!parse_options(argc, argv, opts))
+    {
+        std::fprintf(stderr,
+                     "usage: %s [--protocol text|v2] [--rate hz] [--knobs 1-%d] [--jitter-us us] [--seconds s] "
+                     "[--min-interval-ms ms] [--endpoint-interval-ms ms]\n",
+                     argv[0], AUDIO_MIXER_MAX_KNOBS);
+        return 2;
+    }
+    audio_mixer::logger_c::instance().set_log_level(audio_mixer::logger_c::LogLevel::WARNING);
+
+    int master = -1;
+    int slave = -1;
+    char name[128] = {};
+    if (openpty(&master, &slave, name, nullptr, nullptr) != 0)
+    {
+        std::perror("openpty");
+        return 1;
+    }
+    termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    marker_log_c markers(opts.binary ? 4096 : 1024);
+    auto media = std::make_unique<recording_media_interface_c>(markers, opts.knobs);
+    auto &recorder = *media;
+    std::string const config_path = write_config(opts);
+
+    boost::asio::io_context context;
+    audio_mixer::audio_mixer_c app(context, config_path, std::move(media));
+    audio_mixer::serial_connection_c connection(context, app.get_frame_mailbox(), app.get_baud_rate());
+    connection.set_ports({name});
+
+    bool exit_app = false;
+    std::atomic<bool> stop_controller(false);
+    controller_stats stats;
+
+    std::thread controller(run_controller, master, std::cref(opts), std::ref(markers), std::ref(recorder),
+                           std::ref(stop_controller), std::ref(stats));
+    std::thread serial_thread([&]() { connection.run(exit_app); });
+    std::thread mixer_thread([&]() { app.run(exit_app); });
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(opts.seconds + 0.5));
+    stop_controller = true;
+    controller.join();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Let the last frames land
+    exit_app = true;
+    mixer_thread.join();
+    serial_thread.join();
+    unlink(config_path.c_str());
+
+    std::vector<double> latencies = recorder.latencies_us();
+    uint64_t const measured_frames = stats.frames_sent - stats.measured_from;
+    double const measured_seconds = opts.seconds;
+    auto frames = app.get_frame_mailbox();
+
+    std::printf("protocol:               %s, %u knobs, %.0f Hz, jitter %u us, min interval %u ms\n",
+                opts.binary ? "v2" : "text", opts.knobs, opts.rate_hz, opts.jitter_us, opts.min_interval_ms);
+    std::printf("frames sent:            %llu (%.1f /s)\n", static_cast<unsigned long long>(stats.frames_sent),
+                static_cast<double>(stats.frames_sent) / stats.send_seconds);
+    std::printf("frames published:       %llu, overwritten before use %llu\n",
+                static_cast<unsigned long long>(frames->published_count()),
+                static_cast<unsigned long long>(frames->overwritten_count()));
+    std::printf("master applies:         %llu, measured %zu of %llu frames (%.1f /s)\n",
+                static_cast<unsigned long long>(recorder.applied()), latencies.size(),
+                static_cast<unsigned long long>(measured_frames),
+                static_cast<double>(latencies.size()) / measured_seconds);
+
+    std::printf("backend calls:          %llu issued, %llu suppressed, %llu coalesced\n",
+                static_cast<unsigned long long>(app.get_dispatcher().issued_count()),
+                static_cast<unsigned long long>(app.get_dispatcher().suppressed_count()),
+                static_cast<unsigned long long>(app.get_dispatcher().coalesced_count()));
+
+    if (latencies.empty())
+    {
+        std::printf("no frames applied\n");
+        return 1;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("frame-to-apply p50:     %9.1f us\n", percentile(latencies, 0.50));
+    std::printf("frame-to-apply p99:     %9.1f us\n", percentile(latencies, 0.99));
+    std::printf("frame-to-apply p99.9:   %9.1f us\n", percentile(latencies, 0.999));
+    std::printf("frame-to-apply max:     %9.1f us\n", latencies.back());
+
+    std::vector<audio_mixer::endpoint> names{audio_mixer::endpoint("master")};
+    for (uint16_t i = 1; i < opts.knobs; i++)
+    {
+        names.emplace_back("bench_" + std::to_string(i));
+    }
+    std::printf("\nper-stage latency (whole run):\n%s",
+                audio_mixer::pipeline_latency_c::instance().summary(names).c_str());
+
+    // The io_context thread started by audio_mixer_c is detached, stop it before the context goes away.
+    context.stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    close(slave);
+    close(master);
+    return 0;
+}
@@ -0,0 +1,194 @@
+// Benchmark: time-to-connect of serial_prober_c against PTY-simulated ports (Linux).
+//
+// Every trial creates a set of pseudo-terminals. One of them behaves like the
+// firmware (AUDIOMIXER_HELLO once a second with a random phase), some stay silent
+// and some print boot noise. The time from probe() to the winning handshake is
+// reported alongside the lower bound of the previous sequential scan, which slept
+// 2 s after opening each port.
+//
+// Usage: serial_probe_bench [ports] [trials]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "logger.hpp"
+#include "protocol.hpp"
+#include "serial_prober.hpp"
+
+namespace
+{
+    struct pty_pair
+    {
+        int master = -1;
+        int slave = -1;
+        std::string path;
+    };
+
+    pty_pair open_pty()
+    {
+        pty_pair pty;
+        char name[128] = {};
+        if (openpty(&pty.master, &pty.slave, name, nullptr, nullptr) != 0)
+        {
+            std::perror("openpty");
+            std::exit(1);
+        }
+        termios tio;
+        tcgetattr(pty.slave, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(pty.slave, TCSANOW, &tio);
+        pty.path = name;
+        return pty;
+    }
+
+    // Firmware-like handshake: HELLO every second until READY comes back.
+    void run_device(int fd, std::chrono::milliseconds phase, std::atomic<bool> &stop)
+    {
+        std::string const hello = std::string(audio_mixer::HANDSHAKE_KEY) + std::string(audio_mixer::PROTOCOL_V2) + "\r\n";
+        auto next_hello = std::chrono::steady_clock::now() + phase;
+        std::string input;
+        while (!stop)
+        {
+            if (std::chrono::steady_clock::now() >= next_hello)
+            {
+                (void)!write(fd, hello.data(), hello.size());
+                next_hello += std::chrono::seconds(1);
+            }
+            pollfd pfd{fd, POLLIN, 0};
+            if (poll(&pfd, 1, 5) > 0 && (pfd.revents & POLLIN))
+            {
+                char buf[64];
+                ssize_t n = read(fd, buf, sizeof(buf));
+                if (n > 0)
+                {
+                    input.append(buf, static_cast<size_t>(n));
+                    if (input.find(audio_mixer::HANDSHAKE_RESPONSE) != std::string::npos)
+                    {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+
+    void run_noise(int fd, std::atomic<bool> &stop)
+    {
+        std::string const noise = "ets Jun  8 2016 00:22:57 rst:0x1 (POWERON_RESET)\r\n";
+        while (!stop)
+        {
+            (void)!write(fd, noise.data(), noise.size());
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t const num_ports = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 8;
+    size_t const trials = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 20;
+    audio_mixer::logger_c::instance().set_log_level(audio_mixer::logger_c::LogLevel::WARNING);
+
+    boost::asio::io_context context;
+    auto work = boost::asio::make_work_guard(context);
+    std::thread context_thread([&context]() { context.run(); });
+
+    audio_mixer::serial_prober_c prober(context, boost::asio::serial_port_base::baud_rate(115200));
+    std::mt19937 rng(7);
+    std::vector<double> connect_ms;
+    std::vector<double> legacy_ms;
+    size_t failures = 0;
+
+    for (size_t trial = 0; trial < trials; trial++)
+    {
+        std::vector<pty_pair> ptys;
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < num_ports; i++)
+        {
+            ptys.emplace_back(open_pty());
+            paths.emplace_back(ptys.back().path);
+        }
+
+        size_t const device = std::uniform_int_distribution<size_t>(0, num_ports - 1)(rng);
+        auto const phase = std::chrono::milliseconds(std::uniform_int_distribution<int>(0, 999)(rng));
+        std::atomic<bool> stop(false);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < num_ports; i++)
+        {
+            if (i == device)
+            {
+                threads.emplace_back(run_device, ptys[i].master, phase, std::ref(stop));
+            }
+            else if (i % 2 == 0)
+            {
+                threads.emplace_back(run_noise, ptys[i].master, std::ref(stop));
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto result = prober.probe(paths, std::chrono::milliseconds(3000));
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        if (result && result->port == paths[device])
+        {
+            connect_ms.emplace_back(std::chrono::duration<double, std::milli>(elapsed).count());
+            // The old scan slept 2 s after opening every port it tried before the device.
+            legacy_ms.emplace_back(2000.0 * static_cast<double>(device + 1) + static_cast<double>(phase.count()));
+        }
+        else
+        {
+            ++failures;
+        }
+
+        stop = true;
+        for (auto &t : threads)
+        {
+            t.join();
+        }
+        if (result)
+        {
+            boost::system::error_code ec;
+            result->serial.close(ec);
+        }
+        for (auto &pty : ptys)
+        {
+            close(pty.master);
+            close(pty.slave);
+        }
+    }
+
+    work.reset();
+    context.stop();
+    context_thread.join();
+
+    if (connect_ms.empty())
+    {
+        std::printf("no successful trials\n");
+        return 1;
+    }
+    std::sort(connect_ms.begin(), connect_ms.end());
+    double legacy_mean = 0;
+    for (double ms : legacy_ms)
+    {
+        legacy_mean += ms / static_cast<double>(legacy_ms.size());
+    }
+
+    std::printf("ports per trial:        %zu (trials %zu, failures %zu)\n", num_ports, trials, failures);
+    std::printf("time-to-connect min:    %8.1f ms\n", connect_ms.front());
+    std::printf("time-to-connect median: %8.1f ms\n", connect_ms[connect_ms.size() / 2]);
+    std::printf("time-to-connect max:    %8.1f ms\n", connect_ms.back());
+    std::printf("sequential scan mean:   %8.1f ms (lower bound)\n", legacy_mean);
+    return failures == 0 ? 0 : 1;
+}
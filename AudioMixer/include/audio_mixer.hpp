@@ -2,17 +2,26 @@
 #define __AUDIO__MIXER___HPP__
 
 #include <boost/asio.hpp>
+#include <array>
+#include <atomic>
+#include <filesystem>
 #include <map>
-#include <regex>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
 
+#include "directory_watcher.hpp"
 #include "endpoint.hpp"
-#include "stack.hpp"
-#ifdef _WIN32
-#include "windows_media_interface.hpp"
-#endif
+#include "frame_parser.hpp"
+#include "frame_mailbox.hpp"
+#include "knob_filter.hpp"
+#include "media_worker.hpp"
+#include "metrics_exporter.hpp"
+#include "mixer_config.hpp"
+#include "os_media_interface.hpp"
+#include "volume_dispatcher.hpp"
+#include "volume_ramp.hpp"
 
 namespace audio_mixer
 {
@@ -23,34 +32,68 @@ namespace audio_mixer
     public:
         audio_mixer_c(boost::asio::io_context &context);
 
-        // TODO: implement config stack
+        /// Brief: Construct with an explicit config file and media backend, e.g. for benchmarks.
+        /// param[in] media: The backend volumes are applied through, may be nullptr.
+        audio_mixer_c(boost::asio::io_context &context, std::string const &config_path,
+                      std::unique_ptr<os_media_interface_c> media);
+
+        /// Brief: Parse the config file and publish it, the mixer switches to it before its next frame.
+        /// Called again by the file watcher whenever the file changes. A file that cannot be
+        /// parsed is logged and the current config is kept.
         void load_configs();
 
-        std::shared_ptr<stack_c> get_data_stack() const;
+        std::shared_ptr<frame_mailbox_c> get_frame_mailbox() const;
 
+        // Of the config in use, mixer thread only
         uint16_t get_data_rate() const;
 
         baud_rate_t get_baud_rate() const;
 
+        // Backend call counters, read them once run() has returned
+        volume_dispatcher_c const &get_dispatcher() const;
+
         void run(bool &exit_app);
-        void update(std::vector<int> const &values);
+        void update(knob_frame const &frame);
 
     private:
         boost::asio::io_context &m_context;
-        std::shared_ptr<stack_c> m_data_stack;
-#ifdef _WIN32
-        audio_mixer::windows_media_interface_c m_media;
-#endif
-        baud_rate_t m_baud_rate;
-        uint16_t m_data_rate_ms;
-        std::regex m_data_pattern;
-        uint16_t m_num_of_knobs;
-        std::vector<endpoint> m_endpoints;
-
-        void update_volumes(std::vector<int> const &values);
-        std::regex create_regex(uint16_t count);
-        std::vector<int> extract_values(std::string &values);
-        std::vector<float> scale_values(std::vector<int> const &values);
+        std::shared_ptr<frame_mailbox_c> m_frames;
+        std::unique_ptr<media_worker_c> m_worker; // Owns the media backend, nullptr without one
+        std::string m_config_path;
+        baud_rate_t m_baud_rate; // From the first load, the serial session is not restarted for a new one
+        std::shared_ptr<mixer_config const> m_config; // Mixer thread only
+        knob_filter_c m_filter;
+        knob_frame m_filtered; // Last frame the filter took, settle() repeats it
+        volume_ramp_c::clock::time_point m_filter_tick; // When the filter settles next, max() once settled
+        volume_dispatcher_c m_dispatcher;
+        volume_ramp_c m_ramp;
+
+        // Newest snapshot, handed over by load_configs()
+        std::mutex m_config_mutex;
+        std::shared_ptr<mixer_config const> m_published;
+        std::atomic<bool> m_config_changed;
+
+        // Reloads on changes to the config file, io_context thread only
+        directory_watcher_c m_config_watcher;
+        boost::asio::steady_timer m_reload_timer;
+        std::filesystem::file_time_type m_config_written;
+
+        std::unique_ptr<metrics_exporter_c> m_metrics; // nullptr unless config.yaml enables an export
+
+        void open_trace();
+        void start_metrics();
+        void watch_config();
+        void schedule_reload();
+        void poll_config();
+        void apply_config();
+        void set_targets(knob_frame const &frame);
+        void settle_filter(volume_ramp_c::clock::time_point now);
+        void set_goals(std::array<float, AUDIO_MIXER_MAX_KNOBS> const &readings, volume_ramp_c::clock::time_point now);
+        volume_ramp_c::clock::time_point next_wakeup() const;
+        void step_ramps(volume_ramp_c::clock::time_point now);
+        void dispatch(volume_dispatcher_c::clock::time_point now, uint64_t received_ns = 0);
+        std::array<float, AUDIO_MIXER_MAX_KNOBS> scale_values(knob_frame const &frame,
+                                                              std::array<float, AUDIO_MIXER_MAX_KNOBS> const &readings);
 
     }; // end class audio_mixer_c
 
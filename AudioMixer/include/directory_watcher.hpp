@@ -0,0 +1,57 @@
+#ifndef __DIRECTORY_WATCHER__HPP__
+#define __DIRECTORY_WATCHER__HPP__
+
+#include <array>
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace audio_mixer
+{
+    // Reports entries appearing in, disappearing from or being rewritten in a directory.
+    //
+    // Backed by inotify on Linux and delivered on the io_context thread. On other
+    // platforms start() returns false and callers fall back to polling.
+    class directory_watcher_c
+    {
+    public:
+        enum class Event
+        {
+            ADDED,    // Created or moved into the directory
+            REMOVED,  // Deleted or moved out of the directory
+            MODIFIED, // Closed after being written
+            RESCAN    // Events were lost, callers should re-scan the directory
+        };
+
+        // What start() watches for, RESCAN is always reported
+        static constexpr uint32_t ENTRIES = 1; // ADDED and REMOVED
+        static constexpr uint32_t WRITES = 2;  // MODIFIED, every writer closing an entry wakes the watcher
+
+        using callback_t = std::function<void(std::string const &name, Event event)>;
+
+        directory_watcher_c(boost::asio::io_context &context);
+        ~directory_watcher_c();
+
+        /// Brief: Start watching a directory.
+        /// param[in] directory: The directory to watch.
+        /// param[in] events: ENTRIES, WRITES or both.
+        /// param[in] callback: Invoked on the io_context thread with the entry name and event.
+        /// returns: False if watching is not supported or the directory cannot be watched.
+        bool start(std::string const &directory, uint32_t events, callback_t callback);
+
+        void stop();
+
+    private:
+#ifdef __linux__
+        void start_read();
+
+        boost::asio::posix::stream_descriptor m_descriptor;
+        alignas(8) std::array<char, 4096> m_buffer;
+#endif
+        callback_t m_callback;
+    };
+
+} // namespace audio_mixer
+
+#endif // __DIRECTORY_WATCHER__HPP__
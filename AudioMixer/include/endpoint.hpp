@@ -1,6 +1,14 @@
 #ifndef __ENDPOINT__HPP__
 #define __ENDPOINT__HPP__
 
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
 namespace audio_mixer
 {
     inline std::string toLower(const std::string &str)
@@ -10,16 +18,51 @@ namespace audio_mixer
         return result;
     }
 
-    // TODO: add support for an endpoint linking to a list of applications.
+    inline char fold_case(char c)
+    {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+
+    // Case-insensitive hash, so maps keyed by folded names can be searched
+    // with a name as the OS reports it without building a lower case copy.
+    struct case_fold_hash
+    {
+        size_t operator()(std::string_view str) const noexcept
+        {
+            // FNV-1a
+            uint64_t hash = 14695981039346656037ULL;
+            for (char c : str)
+            {
+                hash ^= static_cast<unsigned char>(fold_case(c));
+                hash *= 1099511628211ULL;
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    struct case_fold_equal
+    {
+        bool operator()(std::string_view a, std::string_view b) const noexcept
+        {
+            return a.size() == b.size() &&
+                   std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) { return fold_case(x) == fold_case(y); });
+        }
+    };
+
     struct endpoint
     {
         std::string name;
+        std::string key; // Lower case name, folded once so comparisons do not allocate
+        // Names, globs or /regexes/ of the applications a group controls,
+        // empty if the endpoint is the single application called name
+        std::vector<std::string> applications;
         float current_volume;
         float set_volume;
         uint32_t pid;
 
         endpoint(std::string const name)
             : name(name),
+              key(toLower(name)),
               current_volume(0),
               set_volume(0),
               pid(0) {
@@ -27,7 +70,7 @@ namespace audio_mixer
 
         inline bool operator==(endpoint const &other) const
         {
-            return toLower(this->name) == toLower(other.name);
+            return this->key == other.key;
         }
     };
 }
@@ -0,0 +1,65 @@
+#ifndef __ENDPOINT_MATCHER__HPP__
+#define __ENDPOINT_MATCHER__HPP__
+
+#include <cstddef>
+#include <deque>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "endpoint.hpp"
+
+namespace audio_mixer
+{
+    // Resolves process names to the endpoint (knob) that controls them.
+    //
+    // Built once per config load from every endpoint's application list. Plain
+    // names go into a case-insensitive hash map, entries with '*' or '?' are
+    // globs and entries written as /.../ are regular expressions, both matched
+    // case-insensitively in config order after the exact names. Callers cache
+    // the result per process, so patterns are only evaluated for new processes.
+    // Immutable once built, safe to share between threads.
+    class endpoint_matcher_c
+    {
+    public:
+        static constexpr int NO_GROUP = -1;
+
+        /// Brief: Compile the application lists of the endpoints.
+        /// "master" and "mic" are devices and never match a process.
+        /// Invalid regular expressions are logged and skipped.
+        explicit endpoint_matcher_c(std::vector<endpoint> const &endpoints);
+
+        endpoint_matcher_c(endpoint_matcher_c const &) = delete;
+        endpoint_matcher_c &operator=(endpoint_matcher_c const &) = delete;
+
+        /// Brief: Find the endpoint a process belongs to.
+        /// param[in] process_name: e.g. "chrome.exe", any case.
+        /// returns: Index of the endpoint in the list the matcher was built from, or NO_GROUP.
+        int match(std::string_view process_name) const;
+
+        // Number of endpoints the matcher was built from
+        size_t size() const { return m_size; }
+
+        // If an application list entry is a glob or regex rather than a name
+        static bool is_pattern(std::string const &entry);
+
+    private:
+        struct pattern
+        {
+            bool is_regex;
+            std::string glob; // Lower case
+            std::regex regex;
+            int group;
+        };
+
+        std::deque<std::string> m_names; // Owns the keys of m_exact
+        std::unordered_map<std::string_view, int, case_fold_hash, case_fold_equal> m_exact;
+        std::vector<pattern> m_patterns;
+        size_t m_size;
+    };
+
+} // namespace audio_mixer
+
+#endif // __ENDPOINT_MATCHER__HPP__
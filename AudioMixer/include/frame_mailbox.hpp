@@ -0,0 +1,65 @@
+#ifndef __FRAME_MAILBOX__HPP__
+#define __FRAME_MAILBOX__HPP__
+
+// Libraries
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "frame_parser.hpp"
+
+namespace audio_mixer
+{
+    // Single-producer/single-consumer "latest value" mailbox for decoded frames.
+    //
+    // Implemented as a triple buffer: the producer and consumer each own one slot and
+    // swap it with the shared middle slot, so neither side ever blocks or allocates.
+    // Only the newest frame is kept; frames replaced before they were read are counted
+    // as overwritten. The consumer may sleep until a frame arrives; the producer only
+    // touches the wake-up mutex when the consumer is actually asleep.
+    class frame_mailbox_c
+    {
+    public:
+        frame_mailbox_c();
+
+        // Publish a frame, replacing any unread one (producer thread only)
+        void publish(knob_frame const &frame);
+
+        // Take the newest unread frame, returns false if nothing new was published (consumer thread only)
+        bool take(knob_frame &frame);
+
+        // Check if an unread frame is waiting
+        bool has_unread() const;
+
+        // Block until an unread frame is waiting or the timeout expires (consumer thread only)
+        bool wait_for_unread(std::chrono::milliseconds timeout);
+
+        // Total number of frames published
+        uint64_t published_count() const;
+
+        // Number of frames replaced before the consumer read them
+        uint64_t overwritten_count() const;
+
+    private:
+        static constexpr uint8_t INDEX_MASK = 0x03;
+        static constexpr uint8_t FRESH_BIT = 0x04;
+
+        std::array<knob_frame, 3> m_slots;
+        uint8_t m_write_index;                   // Owned by the producer
+        uint8_t m_read_index;                    // Owned by the consumer
+        alignas(64) std::atomic<uint8_t> m_middle; // Shared slot index, FRESH_BIT when unread
+        alignas(64) std::atomic<uint64_t> m_published;
+        std::atomic<uint64_t> m_overwritten;
+
+        // Wake-up path for a sleeping consumer
+        std::atomic<bool> m_waiting;
+        std::mutex m_wait_mutex;
+        std::condition_variable m_wait_cv;
+    };
+
+} // end namespace audio_mixer
+
+#endif // __FRAME_MAILBOX__HPP__
@@ -0,0 +1,40 @@
+#ifndef __FRAME_PARSER__HPP__
+#define __FRAME_PARSER__HPP__
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// Upper bound on knobs a single frame can carry.
+#define AUDIO_MIXER_MAX_KNOBS 64
+
+namespace audio_mixer
+{
+    // Decoded knob readings from one controller frame.
+    struct knob_frame
+    {
+        std::array<uint16_t, AUDIO_MIXER_MAX_KNOBS> values;
+        uint16_t count;
+        uint8_t bits; // Resolution of the values, e.g. 10 for 0-1023
+        uint64_t received_ns;  // When the serial read carrying the frame completed
+        uint64_t published_ns; // When the frame was handed to the mixer
+
+        knob_frame()
+            : values{},
+              count(0),
+              bits(10),
+              received_ns(0),
+              published_ns(0) {
+              };
+    };
+
+    /// Brief: Validate and decode a "a|b|c|d|e" frame in a single pass.
+    /// param[in] line: The frame text, without the trailing newline.
+    /// param[in] expected_count: The number of values required, or 0 to accept any count.
+    /// param[out] frame: Receives the decoded values. Unspecified if parsing fails.
+    /// returns: True if the line is a well formed frame with the expected number of values.
+    bool parse_frame(std::string_view line, uint16_t expected_count, knob_frame &frame);
+
+} // namespace audio_mixer
+
+#endif // __FRAME_PARSER__HPP__
@@ -0,0 +1,81 @@
+#ifndef __KNOB_FILTER__HPP__
+#define __KNOB_FILTER__HPP__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_parser.hpp"
+
+// Longest median window, odd
+#define AUDIO_MIXER_MAX_MEDIAN 7
+
+namespace audio_mixer
+{
+    // Removes ADC noise from knob readings before they are scaled.
+    //
+    // A median-of-N drops single sample spikes, then a One-Euro filter smooths
+    // what is left: a low cutoff holds a resting knob still, and the cutoff
+    // rises with the knob's speed so turning it does not lag. State is kept
+    // per stage as one array across knobs, so every step is a flat loop over
+    // the knobs the compiler can vectorize.
+    //
+    // A controller that only reports changes sends nothing once a knob stops,
+    // so settle() re-feeds the last reading on the mixer tick until the median
+    // window and the One-Euro state have caught up with it.
+    class knob_filter_c
+    {
+    public:
+        knob_filter_c();
+
+        /// Brief: Set the filter parameters and drop the filter state.
+        /// param[in] median: Median window, 1 disables it, even values are rounded up.
+        /// param[in] min_cutoff_hz: One-Euro cutoff of a resting knob, 0 disables the stage.
+        /// param[in] beta: Cutoff increase in Hz per full scale per second of knob speed.
+        void configure(size_t median, float min_cutoff_hz, float beta);
+
+        /// Brief: Forget the history, the next frame is taken as is.
+        void reset();
+
+        /// Brief: Filter one frame.
+        /// param[in] frame: Raw readings, received_ns is used as the sample time.
+        /// param[out] output: Filtered readings in ADC units for the first frame.count knobs.
+        void apply(knob_frame const &frame, std::array<float, AUDIO_MIXER_MAX_KNOBS> &output);
+
+        /// Brief: Filter the last frame's readings again, as if the frame repeated.
+        /// param[in] now_ns: Sample time on the steady clock, like knob_frame::received_ns.
+        /// param[out] output: Filtered readings for the knobs of the last frame.
+        void settle(uint64_t now_ns, std::array<float, AUDIO_MIXER_MAX_KNOBS> &output);
+
+        // False while the output still lags the last reading, settle() has work until then
+        bool settled() const { return m_settled; }
+
+    private:
+        void step(uint64_t now_ns, std::array<float, AUDIO_MIXER_MAX_KNOBS> &output);
+        void median(size_t count, std::array<uint16_t, AUDIO_MIXER_MAX_KNOBS> &output);
+        void one_euro(size_t count, float dt, float full_scale, std::array<float, AUDIO_MIXER_MAX_KNOBS> &values);
+
+        // Settings
+        size_t m_median;
+        float m_min_cutoff;
+        float m_beta;
+
+        // Median window, m_history[slot][knob]
+        std::array<std::array<uint16_t, AUDIO_MIXER_MAX_KNOBS>, AUDIO_MIXER_MAX_MEDIAN> m_history;
+        size_t m_head;
+
+        // One-Euro state
+        std::array<float, AUDIO_MIXER_MAX_KNOBS> m_value;
+        std::array<float, AUDIO_MIXER_MAX_KNOBS> m_speed;
+
+        // Frame the state belongs to, a change in shape restarts the filter
+        std::array<uint16_t, AUDIO_MIXER_MAX_KNOBS> m_raw;
+        uint16_t m_count;
+        uint8_t m_bits;
+        uint64_t m_last_ns;
+        bool m_settled;
+    };
+
+} // namespace audio_mixer
+
+#endif // __KNOB_FILTER__HPP__
@@ -0,0 +1,93 @@
+#ifndef __LATENCY_HISTOGRAM__HPP__
+#define __LATENCY_HISTOGRAM__HPP__
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace audio_mixer
+{
+    // Fixed-memory, log-linear (HDR style) histogram of nanosecond durations.
+    //
+    // A value is bucketed by its highest set bit plus the next SUB_BUCKET_BITS bits,
+    // so every bucket is within 1/16 (~6%) of the values it holds; values below 16 ns
+    // are exact and anything past MAX_EXPONENT (~4.3 s) lands in the last bucket.
+    // Recording is a bit scan and two relaxed stores, there is one writer per
+    // histogram and any thread may read it.
+    class latency_histogram_c
+    {
+    public:
+        static constexpr unsigned SUB_BUCKET_BITS = 4;
+        static constexpr unsigned MAX_EXPONENT = 32;
+        static constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BUCKET_BITS;
+        static constexpr size_t BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        latency_histogram_c();
+
+        // Record one duration (owning thread only)
+        void record(uint64_t ns)
+        {
+            auto &bucket = m_counts[bucket_index(ns)];
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if (ns > m_max.load(std::memory_order_relaxed))
+            {
+                m_max.store(ns, std::memory_order_relaxed);
+            }
+        }
+
+        // Number of recorded durations
+        uint64_t count() const;
+
+        // Largest recorded duration, exact
+        uint64_t max() const;
+
+        /// Brief: Estimate a percentile from the buckets.
+        /// param[in] percentile: 0.0 - 100.0
+        /// returns: The highest value equivalent to the bucket holding the percentile, 0 if empty.
+        uint64_t value_at_percentile(double percentile) const;
+
+    private:
+        static size_t bucket_index(uint64_t ns)
+        {
+            if (ns < SUB_BUCKETS)
+            {
+                return static_cast<size_t>(ns);
+            }
+            unsigned exponent = highest_bit(ns);
+            if (exponent >= MAX_EXPONENT)
+            {
+                return BUCKETS - 1;
+            }
+            unsigned const shift = exponent - SUB_BUCKET_BITS;
+            size_t const sub = static_cast<size_t>(ns >> shift) - SUB_BUCKETS;
+            return (shift + 1) * SUB_BUCKETS + sub;
+        }
+
+        static unsigned highest_bit(uint64_t value)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return static_cast<unsigned>(index);
+#else
+            return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#endif
+        }
+
+        // Highest value that falls into a bucket
+        static uint64_t bucket_upper_bound(size_t index);
+
+        std::array<std::atomic<uint64_t>, BUCKETS> m_counts;
+        std::atomic<uint64_t> m_count;
+        std::atomic<uint64_t> m_max;
+    };
+
+} // namespace audio_mixer
+
+#endif // __LATENCY_HISTOGRAM__HPP__
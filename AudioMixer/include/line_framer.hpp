@@ -0,0 +1,120 @@
+#ifndef __LINE_FRAMER__HPP__
+#define __LINE_FRAMER__HPP__
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Size of the fixed receive buffer, must hold at least one full line.
+#define AUDIO_MIXER_SERIAL_BUFFER_SIZE 512
+
+namespace audio_mixer
+{
+    // Splits a byte stream into delimited records inside one fixed buffer.
+    //
+    // Reads land directly in the free tail of the buffer (write_ptr/commit). Complete
+    // records are handed out as string views into the buffer and only the trailing
+    // partial record is moved back to the front, so nothing is allocated or copied
+    // per record.
+    class line_framer_c
+    {
+    public:
+        explicit line_framer_c(char delimiter = '\n')
+            : m_buffer{},
+              m_size(0),
+              m_scanned(0),
+              m_overflows(0),
+              m_delimiter(delimiter)
+        {
+        }
+
+        // Where the next read should write to
+        char *write_ptr()
+        {
+            return m_buffer.data() + m_size;
+        }
+
+        // How many bytes the next read may write
+        size_t write_space() const
+        {
+            return m_buffer.size() - m_size;
+        }
+
+        // Mark bytes written at write_ptr() as received
+        void commit(size_t count)
+        {
+            m_size += count;
+        }
+
+        // Drop any buffered bytes, e.g. when a new session starts
+        void clear()
+        {
+            m_size = 0;
+            m_scanned = 0;
+        }
+
+        void set_delimiter(char delimiter)
+        {
+            m_delimiter = delimiter;
+        }
+
+        // Number of records discarded because they did not fit in the buffer
+        uint64_t overflow_count() const
+        {
+            return m_overflows;
+        }
+
+        /// Brief: Invoke fn(std::string_view) for every complete record, without the delimiter.
+        /// The views are only valid during the callback.
+        /// returns: The number of records handed out.
+        template <typename Fn>
+        size_t for_each_record(Fn &&fn)
+        {
+            char *data = m_buffer.data();
+            size_t start = 0;
+            size_t pos = m_scanned;
+            size_t records = 0;
+
+            while (pos < m_size)
+            {
+                auto hit = static_cast<char *>(std::memchr(data + pos, m_delimiter, m_size - pos));
+                if (hit == nullptr)
+                {
+                    break;
+                }
+                size_t end = static_cast<size_t>(hit - data);
+                fn(std::string_view(data + start, end - start));
+                ++records;
+                start = end + 1;
+                pos = start;
+            }
+
+            // Keep the partial record at the front of the buffer
+            if (start > 0)
+            {
+                std::memmove(data, data + start, m_size - start);
+                m_size -= start;
+            }
+            m_scanned = m_size;
+
+            // A record longer than the buffer can never complete, drop it
+            if (m_size == m_buffer.size())
+            {
+                clear();
+                ++m_overflows;
+            }
+            return records;
+        }
+
+    private:
+        std::array<char, AUDIO_MIXER_SERIAL_BUFFER_SIZE> m_buffer;
+        size_t m_size;    // Bytes currently buffered
+        size_t m_scanned; // Leading bytes already known to hold no delimiter
+        uint64_t m_overflows;
+        char m_delimiter;
+    };
+
+} // namespace audio_mixer
+
+#endif // __LINE_FRAMER__HPP__
@@ -1,14 +1,22 @@
 #ifndef __AUDIO_MIXER_LOGGER_HPP__
 #define __AUDIO_MIXER_LOGGER_HPP__
 
+#include <atomic>
+#include <charconv>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <filesystem> // C++17
 #include <ctime>
+#include <thread>
 #include <vector>
 #include <algorithm>
 
@@ -16,9 +24,23 @@
 #include <windows.h>
 #endif
 
+// Lowest level compiled in: 0 DEBUG, 1 INFO, 2 WARNING, 3 ERROR. The AUDIO_MIXER_LOG_*
+// macros below it expand to nothing that runs, their arguments are never evaluated.
+#ifndef AUDIO_MIXER_MIN_LOG_LEVEL
+#define AUDIO_MIXER_MIN_LOG_LEVEL 0
+#endif
+
 namespace audio_mixer
 {
 
+    // Writes timestamped lines to audiomixer.log, rolled at 5 MB.
+    //
+    // Synchronous by default: every call formats, writes and flushes under a
+    // mutex. In async mode callers only copy the message into a lock-free ring
+    // and return, a background thread formats and writes whatever accumulated
+    // in one batch. Warnings and errors wake the writer at once, everything else
+    // is written at least every 20 ms. When the ring is full, DEBUG and INFO
+    // records are dropped and counted; warnings and errors wait for space.
     class logger_c
     {
     public:
@@ -43,185 +65,190 @@ namespace audio_mixer
             return inst;
         }
 
-        void log(LogLevel level, const std::string &msg)
+        /// Brief: Switch between writing on the caller's thread and the background writer.
+        /// Switch before other threads log, e.g. at the start and end of main. Turning async
+        /// mode off writes everything still queued.
+        void set_async(bool async);
+
+        /// Brief: Log to another file, e.g. for benchmarks.
+        void set_file(std::string const &path);
+
+        // False if messages of this level are currently filtered out
+        bool enabled(LogLevel level) const
         {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (level < m_log_level)
-            {
-                return;
-            }
+            return level >= m_log_level;
+        }
 
-            checkRolling();
-            // Get current time
-            auto now = std::chrono::system_clock::now();
-            std::time_t now_c = std::chrono::system_clock::to_time_t(now);
-            std::tm tm_buf;
-#ifdef _WIN32
-            localtime_s(&tm_buf, &now_c);
-#else
-            localtime_r(&now_c, &tm_buf);
-#endif
-            logfile_ << "[" << std::put_time(&tm_buf, "%Y-%m-%d %H:%M:%S") << "] " << msg << std::endl;
-            logfile_.flush();
+        void log(LogLevel level, std::string_view msg);
+
+        /// Brief: Log the arguments one after another, without building temporary strings.
+        /// Strings, characters, numbers and bools are appended to a per-thread buffer that
+        /// keeps its capacity, so steady state logging does not allocate. Prefer the
+        /// AUDIO_MIXER_LOG_* macros, which check the level before evaluating anything.
+        template <typename... Args>
+        void write(LogLevel level, Args const &...args)
+        {
+            std::string &buffer = format_buffer();
+            buffer.clear();
+            (append(buffer, args), ...);
+            log(level, buffer);
         }
 
         void log_debug(std::string const &msg)
         {
-            log(LogLevel::DEBUG, "[DEBUG] " + msg);
+            log(LogLevel::DEBUG, msg);
         }
 
         void log_info(std::string const &msg)
         {
-            log(LogLevel::INFO, "[INFO] " + msg);
+            log(LogLevel::INFO, msg);
         }
 
         void log_warning(std::string const &msg)
         {
-            log(LogLevel::WARNING, "[WARNING] " + msg);
+            log(LogLevel::WARNING, msg);
         }
-   
+
         void log_error(std::string const &msg)
         {
-            log(LogLevel::LOG_ERROR, "[ERROR] " + msg);
+            log(LogLevel::LOG_ERROR, msg);
         }
 
-    private: 
-        // Maximum number of rolled log files to keep.
-        uint8_t const m_max_log_files = 5; 
+        // Records dropped because the ring was full, async mode only
+        uint64_t dropped_count() const { return m_dropped_total.load(std::memory_order_relaxed); }
 
-        logger_c()
-        {
-            // Determine log file path
-            std::string path = "audiomixer.log";
-#ifdef _WIN32
-            char exePath[MAX_PATH];
-            GetModuleFileNameA(nullptr, exePath, MAX_PATH);
-            std::string exeDir(exePath);
-            auto pos = exeDir.find_last_of("\\/");
-            if (pos != std::string::npos)
-            {
-                exeDir = exeDir.substr(0, pos + 1);
-                path = exeDir + "audiomixer.log";
-            }
-#endif
-            logPath_ = path;
-            openLogFile();
+    private:
+        // Ring slots, a power of two
+        static constexpr size_t RING_SIZE = 2048;
+        // Messages up to this length are copied into the slot, longer ones allocate
+        static constexpr size_t RECORD_TEXT = 224;
 
-            // Set default log level
-            m_log_level = LogLevel::INFO; // Default to INFO level
-        }
+        // Initial capacity of the per-thread format buffer
+        static constexpr size_t FORMAT_BUFFER = 512;
 
-        ~logger_c()
+        struct record
         {
-            if (logfile_.is_open())
-                logfile_.close();
-        }
-
-        // Check file size and perform rolling if needed.
-        void checkRolling()
-        {
-            constexpr std::uintmax_t MAX_SIZE = 5 * 1024 * 1024; // 5 MB
-            std::error_code ec;
-            if (std::filesystem::exists(logPath_, ec))
-            {
-                auto size = std::filesystem::file_size(logPath_, ec);
-                if (!ec && size >= MAX_SIZE)
-                {
-                    // Close current file
-                    logfile_.close();
-                    
-                    // Create a timestamp suffix for the backup filename
-                    auto t = std::time(nullptr);
-                    std::tm tm_snapshot;
-#ifdef _WIN32
-                    localtime_s(&tm_snapshot, &t);
-#else
-                    localtime_r(&t, &tm_snapshot);
-#endif
-                    std::ostringstream oss;
-                    oss << std::put_time(&tm_snapshot, "%Y%m%d_%H%M%S");
-                    std::string backupName = logPath_ + "." + oss.str();
+            std::atomic<uint64_t> sequence; // Position + 1 once written, position + RING_SIZE once free
+            LogLevel level;
+            std::chrono::system_clock::time_point time;
+            size_t length;
+            char text[RECORD_TEXT];
+            std::string overflow; // Text of a message longer than RECORD_TEXT
+        };
 
-                    // Rename the current log file
-                    std::filesystem::rename(logPath_, backupName, ec);
+        // Maximum number of rolled log files to keep.
+        uint8_t const m_max_log_files = 5;
 
-                    // Clean up old rolled logs if too many exist.
-                    cleanupOldLogs();
+        logger_c();
+        ~logger_c();
 
-                    // Reopen a new log file
-                    openLogFile();
-                }
-            }
+        static std::string &format_buffer()
+        {
+            thread_local std::string buffer = []() {
+                std::string initial;
+                initial.reserve(FORMAT_BUFFER);
+                return initial;
+            }();
+            return buffer;
         }
 
-        // Delete the oldest log files if we have more than m_max_log_files.
-        void cleanupOldLogs()
-        {
-            namespace fs = std::filesystem;
-            fs::path logFilePath(logPath_);
-            fs::path logDir = logFilePath.parent_path();
-            std::string baseName = logFilePath.filename().string(); // e.g. "audiomixer.log"
-            std::vector<fs::directory_entry> rolledFiles;
-
-            // Iterate over directory contents and filter those matching the backup pattern.
-            for (const auto &entry : fs::directory_iterator(logDir))
-            {
-                if (entry.is_regular_file())
-                {
-                    std::string fname = entry.path().filename().string();
-                    // Check if the filename starts with the base name plus a dot.
-                    if (fname.rfind(baseName + ".", 0) == 0)
-                    {
-                        rolledFiles.push_back(entry);
-                    }
-                }
-            }
-
-            // If there are too many, sort by last write time and remove the oldest.
-            if (rolledFiles.size() > m_max_log_files)
-            {
-                std::sort(rolledFiles.begin(), rolledFiles.end(), [](const fs::directory_entry &a, const fs::directory_entry &b)
-                {
-                    return fs::last_write_time(a.path()) < fs::last_write_time(b.path());
-                });
-                std::size_t numToDelete = rolledFiles.size() - m_max_log_files;
-                for (std::size_t i = 0; i < numToDelete; ++i)
-                {
-                    fs::remove(rolledFiles[i].path());
-                }
-            }
-        }
+        static void append(std::string &out, std::string_view text) { out.append(text); }
+        static void append(std::string &out, std::string const &text) { out.append(text); }
+        static void append(std::string &out, char const *text) { out.append(text); }
+        static void append(std::string &out, char c) { out.push_back(c); }
+        static void append(std::string &out, bool value) { out.append(value ? "true" : "false"); }
 
-        void openLogFile()
+        template <typename T>
+        static std::enable_if_t<std::is_arithmetic_v<T>> append(std::string &out, T value)
         {
-            logfile_.open(logPath_, std::ios::app);
+            char digits[32];
+            auto const result = std::to_chars(digits, digits + sizeof(digits), value);
+            out.append(digits, result.ptr);
         }
 
+        void push(LogLevel level, std::chrono::system_clock::time_point time, std::string_view msg);
+        void run_writer();
+        void drain();
+        void format(LogLevel level, std::chrono::system_clock::time_point time, char const *text, size_t length);
+        void write_batch();
+        void checkRolling(size_t incoming);
+        void cleanupOldLogs();
+        void openLogFile();
+
         std::ofstream logfile_;
         std::mutex mutex_;
         std::string logPath_;
+        uintmax_t m_file_size; // Tracked as lines are written, the file is only stat'ed on open
+        std::string m_batch;   // Formatted lines not yet written, under mutex_
+        std::time_t m_time_second;
+        char m_time_text[32]; // m_time_second formatted, reused within the second
+
+        // Async mode
+        std::unique_ptr<record[]> m_ring;
+        alignas(64) std::atomic<uint64_t> m_head; // Next position to claim
+        alignas(64) uint64_t m_tail;              // Next position to write, writer thread only
+        std::atomic<uint64_t> m_dropped;          // Not yet reported in the log
+        std::atomic<uint64_t> m_dropped_total;
+        std::atomic<bool> m_async;
+        std::atomic<bool> m_stop;
+        std::atomic<bool> m_waiting;
+        std::mutex m_wait_mutex;
+        std::condition_variable m_wait_cv;
+        std::thread m_writer;
     };
 
     inline void log_debug(const std::string &msg)
     {
-        logger_c::instance().log_debug(msg);
+        if constexpr (logger_c::DEBUG >= AUDIO_MIXER_MIN_LOG_LEVEL)
+        {
+            logger_c::instance().log_debug(msg);
+        }
     }
 
     inline void log_info(const std::string &msg)
     {
-        logger_c::instance().log_info(msg);
+        if constexpr (logger_c::INFO >= AUDIO_MIXER_MIN_LOG_LEVEL)
+        {
+            logger_c::instance().log_info(msg);
+        }
     }
 
     inline void log_warning(const std::string &msg)
     {
-        logger_c::instance().log_warning(msg);
+        if constexpr (logger_c::WARNING >= AUDIO_MIXER_MIN_LOG_LEVEL)
+        {
+            logger_c::instance().log_warning(msg);
+        }
     }
 
     inline void log_error(const std::string &msg)
     {
-        logger_c::instance().log_error(msg);
+        if constexpr (logger_c::LOG_ERROR >= AUDIO_MIXER_MIN_LOG_LEVEL)
+        {
+            logger_c::instance().log_error(msg);
+        }
     }
 
 } // namespace audio_mixer
 
+// Log through logger_c::write if the level is compiled in and enabled, arguments are
+// only evaluated then, e.g. AUDIO_MIXER_LOG_DEBUG("Data received from ", port, " - ", line)
+#define AUDIO_MIXER_LOG(level, ...)                                                 \
+    do                                                                              \
+    {                                                                               \
+        if constexpr ((level) >= AUDIO_MIXER_MIN_LOG_LEVEL)                         \
+        {                                                                           \
+            auto &audio_mixer_logger_ = ::audio_mixer::logger_c::instance();        \
+            if (audio_mixer_logger_.enabled(level))                                 \
+            {                                                                       \
+                audio_mixer_logger_.write(level, __VA_ARGS__);                      \
+            }                                                                       \
+        }                                                                           \
+    } while (false)
+
+#define AUDIO_MIXER_LOG_DEBUG(...) AUDIO_MIXER_LOG(::audio_mixer::logger_c::DEBUG, __VA_ARGS__)
+#define AUDIO_MIXER_LOG_INFO(...) AUDIO_MIXER_LOG(::audio_mixer::logger_c::INFO, __VA_ARGS__)
+#define AUDIO_MIXER_LOG_WARNING(...) AUDIO_MIXER_LOG(::audio_mixer::logger_c::WARNING, __VA_ARGS__)
+#define AUDIO_MIXER_LOG_ERROR(...) AUDIO_MIXER_LOG(::audio_mixer::logger_c::LOG_ERROR, __VA_ARGS__)
+
 #endif // __AUDIO_MIXER_LOGGER_HPP__
@@ -0,0 +1,97 @@
+#ifndef __MEDIA_WORKER__HPP__
+#define __MEDIA_WORKER__HPP__
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "endpoint.hpp"
+#include "endpoint_matcher.hpp"
+#include "frame_parser.hpp"
+#include "os_media_interface.hpp"
+
+namespace audio_mixer
+{
+    // Owns the media backend and applies volumes on its own thread.
+    //
+    // Commands go through one slot per endpoint: submit() stores the volumes and
+    // sets the endpoints' pending bits at once, the worker swaps the pending mask
+    // out and reads the slots, so the changes of one frame land in one batch.
+    // A command that arrives before the worker got to the last one replaces it,
+    // so a burst costs at most one backend write per endpoint and the mixer
+    // never waits for the OS. Submitting is lock-free; the wake-up mutex is only
+    // touched when the worker is asleep.
+    class media_worker_c
+    {
+    public:
+        explicit media_worker_c(std::unique_ptr<os_media_interface_c> media);
+        ~media_worker_c();
+
+        media_worker_c(media_worker_c const &) = delete;
+        media_worker_c &operator=(media_worker_c const &) = delete;
+
+        /// Brief: Hand the worker the endpoints volume_change::index refers to, from the submitting thread.
+        /// Takes effect before the next batch. Queued commands and failures for the old indexes are
+        /// dropped, so a reordered config never applies them to whatever endpoint took the index.
+        void configure(std::vector<endpoint> endpoints, std::shared_ptr<endpoint_matcher_c const> matcher);
+
+        /// Brief: Queue volumes, replacing queued ones for the same endpoints (one producer thread only).
+        /// param[in] mask: Bitmask of the endpoints to set.
+        /// param[in] volumes: New volumes by endpoint index, only those in mask are read.
+        /// param[in] received_ns: When the frame behind them was read, 0 if there was none.
+        void submit(uint64_t mask, std::array<float, AUDIO_MIXER_MAX_KNOBS> const &volumes, uint64_t received_ns);
+
+        /// Brief: Endpoints whose last write was not applied, including writes the backend
+        /// reported as failed after their batch, cleared by the call.
+        uint64_t take_failed();
+
+        // Backend batches made
+        uint64_t batch_count() const { return m_batches.load(std::memory_order_relaxed); }
+
+        // Commands replaced by a newer one before they were written
+        uint64_t replaced_count() const { return m_replaced.load(std::memory_order_relaxed); }
+
+    private:
+        struct configuration
+        {
+            std::vector<endpoint> endpoints;
+            std::shared_ptr<endpoint_matcher_c const> matcher;
+        };
+
+        void run();
+        bool has_work() const;
+        void apply(uint64_t pending);
+
+        std::unique_ptr<os_media_interface_c> m_media;
+        std::unique_ptr<configuration> m_config; // Worker thread only
+
+        // Command slots, float bits and the frame time of the newest command per endpoint
+        std::array<std::atomic<uint32_t>, AUDIO_MIXER_MAX_KNOBS> m_volumes;
+        std::array<std::atomic<uint64_t>, AUDIO_MIXER_MAX_KNOBS> m_received_ns;
+        alignas(64) std::atomic<uint64_t> m_pending;
+        alignas(64) std::atomic<uint64_t> m_failed;
+        std::atomic<uint64_t> m_batches;
+        std::atomic<uint64_t> m_replaced;
+
+        // New configuration handed over by configure()
+        std::mutex m_config_mutex;
+        std::unique_ptr<configuration> m_next_config;
+        std::atomic<bool> m_config_changed;
+
+        // Wake-up path for a sleeping worker
+        std::atomic<bool> m_stop;
+        std::atomic<bool> m_waiting;
+        std::mutex m_wait_mutex;
+        std::condition_variable m_wait_cv;
+
+        std::thread m_thread;
+    };
+
+} // namespace audio_mixer
+
+#endif // __MEDIA_WORKER__HPP__
@@ -0,0 +1,113 @@
+#ifndef __METRICS__HPP__
+#define __METRICS__HPP__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace audio_mixer
+{
+    enum class Counter : uint8_t
+    {
+        RECORDS_RECEIVED,  // Lines or packets read from the controller
+        FRAMES_PARSED,     // Frames decoded and published to the mixer
+        FRAMES_DISCARDED,  // Malformed lines and corrupt packets
+        FRAMES_LOST,       // Packets missing from the binary protocol's sequence
+        SIZE_MISMATCHES,   // Frames whose knob count does not match num_of_knobs
+        HEARTBEATS,        // Heartbeats received
+        RECONNECTS,        // Serial sessions after the first one
+        BACKEND_CALLS,     // Volumes handed to the media backend
+        BACKEND_NOT_FOUND, // Volumes for applications that are not playing audio
+        BACKEND_FAILURES,  // Volumes the backend failed to set
+        CONFIG_RELOADS,    // config.yaml changes applied without a restart
+        COUNT
+    };
+
+    enum class Gauge : uint8_t
+    {
+        CONNECTED, // 1 while a serial session is running
+        ENDPOINTS, // Endpoints in the config in use
+        COUNT
+    };
+
+    // Process wide health counters.
+    //
+    // Updating a counter or gauge is one relaxed atomic operation on its own cache
+    // line, so the serial, mixer and media worker threads never contend or lock.
+    // Values owned elsewhere, e.g. the frame mailbox counters, are registered as
+    // sources and only read on export. render() produces the Prometheus text
+    // format, see metrics_exporter_c for the socket and textfile outputs.
+    class metrics_c
+    {
+    public:
+        static metrics_c &instance()
+        {
+            static metrics_c inst;
+            return inst;
+        }
+
+        void add(Counter counter, uint64_t count = 1)
+        {
+            m_counters[static_cast<size_t>(counter)].value.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        void set(Gauge gauge, int64_t value)
+        {
+            m_gauges[static_cast<size_t>(gauge)].value.store(static_cast<uint64_t>(value), std::memory_order_relaxed);
+        }
+
+        uint64_t get(Counter counter) const
+        {
+            return m_counters[static_cast<size_t>(counter)].value.load(std::memory_order_relaxed);
+        }
+
+        int64_t get(Gauge gauge) const
+        {
+            return static_cast<int64_t>(m_gauges[static_cast<size_t>(gauge)].value.load(std::memory_order_relaxed));
+        }
+
+        /// Brief: Export a counter owned elsewhere, replaces a source with the same name.
+        /// param[in] name: Full metric name, e.g. "audiomixer_mailbox_overwritten_total".
+        /// param[in] read: Called on export from the exporting thread, keeps what it captures alive.
+        void add_source(std::string const &name, std::string const &help, std::function<uint64_t()> read);
+
+        /// Brief: All metrics in the Prometheus text exposition format.
+        /// The frame rate is measured between two calls that are at least a second apart.
+        std::string render();
+
+    private:
+        struct alignas(64) cell
+        {
+            std::atomic<uint64_t> value{0};
+        };
+
+        struct source
+        {
+            std::string name;
+            std::string help;
+            std::function<uint64_t()> read;
+        };
+
+        metrics_c() : m_rate_frames(0), m_rate_time(std::chrono::steady_clock::now()), m_frame_rate(0.0)
+        {
+        }
+
+        std::array<cell, static_cast<size_t>(Counter::COUNT)> m_counters;
+        std::array<cell, static_cast<size_t>(Gauge::COUNT)> m_gauges;
+
+        // Export side
+        std::mutex m_mutex;
+        std::vector<source> m_sources;
+        uint64_t m_rate_frames;
+        std::chrono::steady_clock::time_point m_rate_time;
+        double m_frame_rate;
+    };
+
+} // namespace audio_mixer
+
+#endif // __METRICS__HPP__
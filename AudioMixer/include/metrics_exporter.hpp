@@ -0,0 +1,50 @@
+#ifndef __METRICS_EXPORTER__HPP__
+#define __METRICS_EXPORTER__HPP__
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <string>
+
+namespace audio_mixer
+{
+    // Publishes metrics_c outside the process, on the io_context thread.
+    //
+    // A client connecting to the Unix socket receives the current metrics and the
+    // connection is closed, e.g. "socat - UNIX-CONNECT:<path>". The textfile is
+    // rewritten periodically for the node_exporter textfile collector, replaced
+    // by a rename so the collector never reads a partial file.
+    class metrics_exporter_c
+    {
+    public:
+        metrics_exporter_c(boost::asio::io_context &context);
+        ~metrics_exporter_c();
+
+        /// Brief: Serve the metrics on a Unix domain socket, replaces a stale socket file.
+        /// param[in] path: Socket path.
+        /// returns: False if local sockets are not supported or the socket cannot be created.
+        bool listen(std::string const &path);
+
+        /// Brief: Write the metrics to a file now and then every interval.
+        /// param[in] path: Target file, node_exporter only collects files ending in ".prom".
+        void write_textfile(std::string const &path, std::chrono::seconds interval);
+
+        void stop();
+
+    private:
+        void write_file();
+        void schedule_write();
+
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+        void start_accept();
+
+        boost::asio::local::stream_protocol::acceptor m_acceptor;
+#endif
+        std::string m_socket_path;
+        std::string m_textfile_path;
+        std::chrono::seconds m_interval;
+        boost::asio::steady_timer m_timer;
+    };
+
+} // namespace audio_mixer
+
+#endif // __METRICS_EXPORTER__HPP__
@@ -0,0 +1,78 @@
+#ifndef __MIXER_CONFIG__HPP__
+#define __MIXER_CONFIG__HPP__
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "endpoint.hpp"
+#include "endpoint_matcher.hpp"
+#include "frame_parser.hpp"
+#include "taper.hpp"
+#include "volume_ramp.hpp"
+
+namespace audio_mixer
+{
+    enum class UpdateMode
+    {
+        POLL,  // Check for a new frame every data_rate_ms
+        EVENT  // Wake as soon as the serial reader publishes a frame
+    };
+
+    // Everything config.yaml configures, parsed in one go.
+    //
+    // Snapshots are built off the mixer thread with the patterns and custom taper
+    // tables already compiled, and never change once published, so the mixer can
+    // switch to a new one between two frames by swapping a pointer.
+    struct mixer_config
+    {
+        uint16_t num_of_knobs = 5;
+        uint32_t baud_rate = 9600;
+        uint16_t data_rate_ms = 50;
+        UpdateMode update_mode = UpdateMode::EVENT;
+        std::chrono::milliseconds min_update_interval{0};
+
+        // trace_c, empty to disable, relative paths start at the config file
+        std::string trace_file;
+        uint32_t trace_records = 65536;
+
+        // metrics_exporter_c, empty to disable, relative paths start at the config file
+        std::string metrics_socket;
+        std::string metrics_textfile;
+        std::chrono::seconds metrics_interval{15};
+
+        // volume_dispatcher_c
+        float volume_step = 0.0f;
+        float dead_band = 0.0f;
+        std::chrono::milliseconds endpoint_min_interval{0};
+
+        // knob_filter_c
+        uint16_t filter_median = 1;
+        float filter_min_cutoff_hz = 0.0f;
+        float filter_beta = 0.0f;
+
+        // volume_ramp_c
+        std::chrono::milliseconds ramp_tick{10};
+        std::array<RampMode, AUDIO_MIXER_MAX_KNOBS> ramp_modes{};
+        std::array<std::chrono::milliseconds, AUDIO_MIXER_MAX_KNOBS> ramp_times{};
+
+        std::vector<endpoint> endpoints;
+        std::array<taper_c, AUDIO_MIXER_MAX_KNOBS> tapers;
+        std::shared_ptr<endpoint_matcher_c const> matcher;
+    };
+
+    /// Brief: Parse a config file into a snapshot.
+    /// Unknown names and unusable values are logged and replaced by defaults.
+    /// param[in] path: Path of config.yaml.
+    /// returns: The snapshot, throws if the file cannot be read or is not valid YAML.
+    std::shared_ptr<mixer_config const> load_mixer_config(std::string const &path);
+
+    /// Brief: Snapshot used when there is no readable config, controls the master volume only.
+    std::shared_ptr<mixer_config const> default_mixer_config();
+
+} // namespace audio_mixer
+
+#endif // __MIXER_CONFIG__HPP__
@@ -1,16 +1,36 @@
 #ifndef __OS__MEDIA_INTERFACE__HPP__
 #define __OS__MEDIA_INTERFACE__HPP__
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "endpoint.hpp"
+#include "endpoint_matcher.hpp"
 
 namespace audio_mixer
 {
+    // One endpoint of a batched volume update
+    struct volume_change
+    {
+        endpoint const *target;
+        size_t index; // Of the endpoint in the list the matcher was built from
+        float volume;
+    };
+
+    enum class ApplyResult : uint8_t
+    {
+        APPLIED,
+        NOT_FOUND, // No such application is playing audio
+        FAILED
+    };
+
     // Abstract class to allow cross-platform support.
     class os_media_interface_c
     {
     public:
+        virtual ~os_media_interface_c() = default;
+
         /// Brief: Initialize the com object
         virtual void initialize() = 0;
 
@@ -30,7 +50,33 @@ namespace audio_mixer
         /// Brief: Set an audio input volume
         /// param[in] float: a float representing the desired volume.
         virtual void set_microphone_volume(float) = 0;
+
+        /// Brief: Route sessions to endpoints by application lists and patterns, see
+        /// endpoint_matcher_c. Backends resolve each session once and then batch by
+        /// volume_change::index. Without a matcher endpoints match by name only.
+        virtual void set_matcher(std::shared_ptr<endpoint_matcher_c const> matcher);
+
+        /// Brief: Apply several volumes at once. "master" and "mic" address the master and
+        /// microphone volumes, other names are applications. Backends override this to share
+        /// one pass over their sessions, the default applies the changes one by one and
+        /// only knows the plain names of a group, not its patterns.
+        /// param[in] changes: The endpoints and their new volumes.
+        /// returns: One result per change, in the same order.
+        virtual std::vector<ApplyResult> set_volumes(std::vector<volume_change> const &changes);
+
+        /// Brief: Endpoints whose write failed after set_volumes() had reported it applied, cleared by the call.
+        /// Backends that only send their writes learn of failures later and report them here. Called
+        /// from the mixer thread while another thread applies, so it must not block.
+        /// returns: Bitmask by volume_change::index, always 0 for backends that wait for their writes.
+        virtual uint64_t take_failed();
+
+    protected:
+        std::shared_ptr<endpoint_matcher_c const> m_matcher;
     };
+
+    /// Brief: Create the media backend for the current platform.
+    /// returns: The backend, or nullptr if the platform has none, e.g. Linux without libpulse.
+    std::unique_ptr<os_media_interface_c> create_media_interface();
 } // end of audio_mixer namespace
 
 #endif // __OS__MEDIA_INTERFACE__HPP__
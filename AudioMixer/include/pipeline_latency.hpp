@@ -0,0 +1,91 @@
+#ifndef __PIPELINE_LATENCY__HPP__
+#define __PIPELINE_LATENCY__HPP__
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "endpoint.hpp"
+#include "frame_parser.hpp"
+#include "latency_histogram.hpp"
+
+namespace audio_mixer
+{
+    // Where a frame spends its time between the serial port and the media backend.
+    enum class Stage : uint8_t
+    {
+        READ,   // Read completion until the record is framed (serial thread)
+        PARSE,  // Text or packet decoding (serial thread)
+        PUSH,   // Publishing into the frame mailbox (serial thread)
+        PICKUP, // Published until run() takes the frame (mixer thread)
+        SCALE,  // Scaling and dead-band filtering (mixer thread)
+        APPLY,  // Queueing the volumes of one frame for the media worker (mixer thread)
+        TOTAL,  // Read completion until the backend applied the volumes (media worker thread)
+        COUNT
+    };
+
+    // Always-on latency histograms for every pipeline stage and every endpoint.
+    class pipeline_latency_c
+    {
+    public:
+        static pipeline_latency_c &instance()
+        {
+            static pipeline_latency_c inst;
+            return inst;
+        }
+
+        // Monotonic timestamp used for every stage
+        static uint64_t now_ns()
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now().time_since_epoch())
+                                             .count());
+        }
+
+        // Record a duration measured by the caller
+        void record(Stage stage, uint64_t ns)
+        {
+            m_stages[static_cast<size_t>(stage)].record(ns);
+        }
+
+        // Record the time from start until now, returns now for chaining stages
+        uint64_t record_since(Stage stage, uint64_t start_ns)
+        {
+            uint64_t const now = now_ns();
+            m_stages[static_cast<size_t>(stage)].record(now > start_ns ? now - start_ns : 0);
+            return now;
+        }
+
+        // Record how long the endpoint at index waited for its backend call
+        void record_endpoint(size_t index, uint64_t ns)
+        {
+            if (index < m_endpoints.size())
+            {
+                m_endpoints[index].record(ns);
+            }
+        }
+
+        latency_histogram_c const &stage(Stage stage) const;
+
+        latency_histogram_c const &endpoint_histogram(size_t index) const;
+
+        /// Brief: One line per stage and per endpoint that recorded anything.
+        /// param[in] endpoints: Names for the endpoint histograms, by knob index.
+        std::string summary(std::vector<endpoint> const &endpoints) const;
+
+    private:
+        pipeline_latency_c() = default;
+
+        std::array<latency_histogram_c, static_cast<size_t>(Stage::COUNT)> m_stages;
+        std::array<latency_histogram_c, AUDIO_MIXER_MAX_KNOBS> m_endpoints;
+    };
+
+    /// Brief: Printable stage name.
+    char const *stage_name(Stage stage);
+
+} // namespace audio_mixer
+
+#endif // __PIPELINE_LATENCY__HPP__
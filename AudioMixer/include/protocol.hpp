@@ -0,0 +1,66 @@
+#ifndef __PROTOCOL__HPP__
+#define __PROTOCOL__HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "frame_parser.hpp"
+
+// Binary protocol v2, negotiated during the handshake.
+//
+// Every packet is COBS encoded and terminated by a 0x00 byte:
+//   [type:1][sequence:1][body...][crc16:2, little endian]
+// A FULL packet body is [count:1] followed by count 12-bit values packed
+// two per three bytes. A DELTA packet body is [count:1][changed bitmask,
+// LSB first][packed values of the changed knobs only], and is applied on
+// top of the last FULL keyframe. The CRC is CRC-16/CCITT-FALSE over
+// type..body.
+#define AUDIO_MIXER_PACKET_MAX_SIZE 128
+
+namespace audio_mixer
+{
+    // Handshake and heartbeat lines, the device opens with HANDSHAKE_KEY (+ PROTOCOL_V2 if supported)
+    constexpr std::string_view HANDSHAKE_KEY = "AUDIOMIXER_HELLO";
+    constexpr std::string_view HANDSHAKE_RESPONSE = "AUDIOMIXER_READY";
+    constexpr std::string_view PROTOCOL_V2 = " V2";
+    constexpr std::string_view HEARTBEAT = "AUDIOMIXER_V1_HEARTBEAT";
+
+    enum class Protocol
+    {
+        TEXT,     // "a|b|c" lines, the v1 fallback
+        BINARY_V2 // COBS framed packets
+    };
+
+    enum class PacketType : uint8_t
+    {
+        FULL = 0x01,      // Every knob value, also the periodic keyframe
+        HEARTBEAT = 0x02, // Keep-alive, no body
+        DELTA = 0x03      // Only the knobs that moved past the device's dead-band
+    };
+
+    struct packet_header
+    {
+        PacketType type;
+        uint8_t sequence;
+    };
+
+    /// Brief: CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF).
+    uint16_t crc16_ccitt(uint8_t const *data, size_t length);
+
+    /// Brief: Decode a COBS encoded record, without its 0x00 delimiter.
+    /// param[out] out: Receives the decoded bytes, must hold at least length bytes.
+    /// returns: The decoded length, or 0 if the record is malformed.
+    size_t cobs_decode(uint8_t const *in, size_t length, uint8_t *out);
+
+    /// Brief: Validate and decode one v2 packet.
+    /// param[in] record: The COBS encoded packet, without its 0x00 delimiter.
+    /// param[out] header: Receives the packet type and sequence number.
+    /// param[in,out] frame: Receives the knob values of a FULL packet. A DELTA packet is
+    /// merged into it and requires it to hold a keyframe with the same knob count.
+    /// returns: False if the packet is malformed, fails its CRC or has no keyframe to apply to.
+    bool decode_packet(std::string_view record, packet_header &header, knob_frame &frame);
+
+} // namespace audio_mixer
+
+#endif // __PROTOCOL__HPP__
@@ -0,0 +1,137 @@
+#ifndef __PULSE_MEDIA_INTERFACE__HPP__
+#define __PULSE_MEDIA_INTERFACE__HPP__
+
+#ifdef AUDIO_MIXER_HAVE_PULSE
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <pulse/pulseaudio.h>
+
+#include "frame_parser.hpp"
+#include "os_media_interface.hpp"
+
+namespace audio_mixer
+{
+    // Linux backend over the PulseAudio protocol, which PipeWire serves as well.
+    //
+    // Keeps one connection on a threaded mainloop and mirrors the default sink,
+    // the default source and every sink-input (application stream) from
+    // subscription events, so lookups never query the server. Volume changes
+    // are sent as asynchronous operations and never wait for the reply, a
+    // write the server rejects is reported through take_failed() instead.
+    // A lost connection is re-established on the next call.
+    class pulse_media_interface_c : public os_media_interface_c
+    {
+    public:
+        pulse_media_interface_c();
+        ~pulse_media_interface_c();
+
+        pulse_media_interface_c(pulse_media_interface_c const &) = delete;
+        pulse_media_interface_c &operator=(pulse_media_interface_c const &) = delete;
+
+        /// Brief: Connect to the sound server
+        void initialize() override;
+
+        /// Brief: Set the volume of the default sink
+        void set_master_volume(float volume) override;
+
+        /// Brief: List application streams from the cache
+        std::vector<endpoint> get_endpoints() override;
+
+        /// Brief: Set the volume of every stream of an application
+        /// returns: False if the application has no stream.
+        bool set_application_volume(endpoint const &app) override;
+
+        /// Brief: Set the volume of the default source
+        void set_microphone_volume(float volume) override;
+
+        /// Brief: Apply a batch under one lock and one pass over the streams
+        std::vector<ApplyResult> set_volumes(std::vector<volume_change> const &changes) override;
+
+        /// Brief: Resolve the streams to endpoint groups, each stream is matched once
+        void set_matcher(std::shared_ptr<endpoint_matcher_c const> matcher) override;
+
+        /// Brief: Endpoints of set_volumes() whose write the server rejected, cleared by the call
+        uint64_t take_failed() override;
+
+    private:
+        // One sink-input, names are lower case for matching
+        struct stream
+        {
+            std::string name;        // Process binary, e.g. "firefox"
+            std::string binary;      // Lower case process binary
+            std::string application; // Lower case application name
+            uint32_t pid;
+            int group; // Endpoint the matcher assigned, NO_GROUP if none
+            uint8_t channels;
+            pa_volume_t volume;
+            bool muted;
+        };
+
+        // Default sink or source
+        struct device
+        {
+            std::string name;
+            uint32_t index; // PA_INVALID_INDEX until its info arrived
+            uint8_t channels;
+            bool muted;
+            bool refreshing; // An info request by index is in flight
+        };
+
+        // Reply context of a batched write, so a rejected write can name its endpoint
+        struct operation_target
+        {
+            pulse_media_interface_c *self;
+            size_t index; // volume_change::index
+        };
+
+        void connect();
+        void disconnect();
+        void ensure_connected();
+        void request_server_info();
+        void request_device_info(bool sink);
+        void store_stream(pa_sink_input_info const &info);
+        void set_device_volume(bool sink, float volume);
+        int resolve_group(stream const &s) const;
+
+        // Send a volume change, the mainloop lock must be held. The reply goes to target,
+        // nullptr for writes outside set_volumes(). Returns false if nothing was sent.
+        bool send_device_volume(bool sink, float volume, operation_target *target);
+        bool send_stream_volume(uint32_t index, stream const &s, float volume, operation_target *target);
+
+        static void on_state(pa_context *context, void *userdata);
+        static void on_event(pa_context *context, pa_subscription_event_type_t type, uint32_t index, void *userdata);
+        static void on_server_info(pa_context *context, pa_server_info const *info, void *userdata);
+        static void on_sink_info(pa_context *context, pa_sink_info const *info, int eol, void *userdata);
+        static void on_source_info(pa_context *context, pa_source_info const *info, int eol, void *userdata);
+        static void on_sink_input_info(pa_context *context, pa_sink_input_info const *info, int eol, void *userdata);
+        static void on_success(pa_context *context, int success, void *userdata);
+        static void on_applied(pa_context *context, int success, void *userdata);
+
+        pa_threaded_mainloop *m_mainloop;
+        pa_context *m_context;
+        std::chrono::steady_clock::time_point m_last_connect;
+
+        // Guarded by the mainloop lock
+        bool m_ready;
+        device m_sink;
+        device m_source;
+        std::unordered_map<uint32_t, stream> m_streams; // By sink-input index
+        std::array<operation_target, AUDIO_MIXER_MAX_KNOBS> m_targets;
+
+        // Set by replies on the mainloop thread, taken by the mixer without the lock
+        std::atomic<uint64_t> m_failed;
+    };
+
+} // end of audio_mixer namespace
+
+#endif // AUDIO_MIXER_HAVE_PULSE
+
+#endif // __PULSE_MEDIA_INTERFACE__HPP__
@@ -3,9 +3,18 @@
 
 #include <iostream>
 #include <boost/asio.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string_view>
 #include <thread>
 #include <memory>
-#include "stack.hpp"
+#include <vector>
+#include "directory_watcher.hpp"
+#include "frame_mailbox.hpp"
+#include "line_framer.hpp"
+#include "protocol.hpp"
+#include "serial_prober.hpp"
 
 namespace audio_mixer
 {
@@ -15,21 +24,65 @@ namespace audio_mixer
         using baud_rate_t = boost::asio::serial_port_base::baud_rate;
 
     public:
-        serial_connection_c(boost::asio::io_context &, std::shared_ptr<stack_c>, baud_rate_t const &);
+        serial_connection_c(boost::asio::io_context &, std::shared_ptr<frame_mailbox_c>, baud_rate_t const &);
 
         ~serial_connection_c();
 
-        bool try_connect_and_handshake(boost::asio::serial_port &, const std::string &);
+        /// Brief: Only probe these ports instead of scanning for devices, e.g. a simulated controller.
+        /// Must be called before run().
+        void set_ports(std::vector<std::string> ports);
+
         void run(bool &exit_app);
 
     private:
         void main_read_loop(bool &exit_app);
 
+        // Session handlers, these only run on the io_context thread.
+        void begin_session();
+        void end_session();
+        void start_read(uint64_t session);
+        void start_heartbeat_timer(uint64_t session);
+        void handle_record(std::string_view record);
+        void handle_line(std::string_view line);
+        void handle_packet(std::string_view record);
+        void publish_frame(uint64_t parse_start, uint64_t parse_end);
+        void acknowledge_heartbeat();
+        void handle_device_event(std::string const &name, directory_watcher_c::Event event);
+
+        std::vector<std::string> wait_for_new_ports(bool &exit_app);
+        std::vector<std::string> candidate_ports() const;
+
         boost::asio::io_context &m_context;
         boost::asio::serial_port m_serial;
         std::string m_port;
         baud_rate_t m_baud;
-        std::shared_ptr<stack_c> m_data_stack;
+        std::shared_ptr<frame_mailbox_c> m_frames;
+        serial_prober_c m_prober;
+        directory_watcher_c m_hotplug;
+        Protocol m_protocol;
+        std::vector<std::string> m_fixed_ports; // Probed instead of scanning when set
+
+        // Owned by the io_context thread
+        boost::asio::steady_timer m_heartbeat_timer;
+        line_framer_c m_framer;
+        knob_frame m_frame;
+        uint64_t m_read_ns; // Completion time of the read being framed
+        std::chrono::steady_clock::time_point m_last_heartbeat;
+        uint64_t m_session;         // Id of the running session, 0 when none
+        std::string m_session_port; // Port of the running session
+        uint64_t m_session_counter;
+        bool m_write_pending;
+        bool m_sequence_valid;
+        uint8_t m_last_sequence;
+        uint64_t m_dropped_frames;
+        uint64_t m_corrupt_packets;
+
+        // Lets the serial thread wait for the session to end
+        std::mutex m_session_mutex;
+        std::condition_variable m_session_cv;
+        bool m_session_active;
+        std::vector<std::string> m_arrived_ports; // Reported by the hotplug watcher
+        bool m_rescan;
     };
 
 } // namespace audio_mixer
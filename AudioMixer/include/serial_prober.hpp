@@ -0,0 +1,48 @@
+#ifndef __SERIAL_PROBER__HPP__
+#define __SERIAL_PROBER__HPP__
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "protocol.hpp"
+
+namespace audio_mixer
+{
+    // A port that completed the handshake, ready for the data session.
+    struct probe_result
+    {
+        std::string port;
+        Protocol protocol;
+        boost::asio::serial_port serial;
+    };
+
+    // Probes every candidate serial port at once for the AudioMixer handshake.
+    //
+    // All ports are read concurrently on the given io_context, each with its own
+    // deadline. The first port to send the handshake key is answered and returned,
+    // the rest are closed straight away.
+    class serial_prober_c
+    {
+        using baud_rate_t = boost::asio::serial_port_base::baud_rate;
+
+    public:
+        serial_prober_c(boost::asio::io_context &context, baud_rate_t const &baud);
+
+        /// Brief: Probe ports until one completes the handshake or every deadline expires.
+        /// Blocks the calling thread, the io_context must be run by another thread.
+        /// param[in] ports: Candidate port names.
+        /// param[in] deadline: How long each port has to send the handshake key.
+        /// returns: The winning port, opened on the io_context, or std::nullopt.
+        std::optional<probe_result> probe(std::vector<std::string> const &ports, std::chrono::milliseconds deadline);
+
+    private:
+        boost::asio::io_context &m_context;
+        baud_rate_t m_baud;
+    };
+
+} // namespace audio_mixer
+
+#endif // __SERIAL_PROBER__HPP__
@@ -0,0 +1,135 @@
+#ifndef __SESSION_REGISTRY__HPP__
+#define __SESSION_REGISTRY__HPP__
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "endpoint.hpp"
+#include "endpoint_matcher.hpp"
+#include "os_media_interface.hpp"
+
+namespace audio_mixer
+{
+    // Volume control of one audio session, valid for as long as the session lives.
+    class session_volume_c
+    {
+    public:
+        virtual ~session_volume_c() = default;
+
+        /// Brief: Set the session volume, 0.0 mutes it.
+        /// returns: False if the session is gone or the call failed.
+        virtual bool set_volume(float volume) = 0;
+
+        /// Brief: Read the session volume.
+        /// returns: False if the session is gone or the call failed.
+        virtual bool get_volume(float &volume) = 0;
+    };
+
+    struct audio_session
+    {
+        uint32_t pid;
+        std::shared_ptr<session_volume_c> volume;
+    };
+
+    // The raw session access a media backend provides to the registry.
+    class session_source_c
+    {
+    public:
+        virtual ~session_source_c() = default;
+
+        /// Brief: Enumerate the live audio sessions without resolving process names.
+        virtual std::vector<audio_session> enumerate_sessions() = 0;
+
+        /// Brief: Resolve a process id to its executable name, e.g. "chrome.exe".
+        /// returns: The name, or an empty string if it cannot be resolved.
+        virtual std::string process_name(uint32_t pid) = 0;
+
+        /// Brief: Counter the backend bumps whenever it knows the session list changed.
+        /// Backends without change notifications may return a constant.
+        virtual uint64_t session_generation() const = 0;
+    };
+
+    // Caches audio sessions by process name so volume changes skip the session walk.
+    //
+    // Process names, and the endpoint group the matcher assigns, are resolved once
+    // per pid and kept while the pid owns a session.
+    // The session list is rebuilt when the source's generation changes, when a cached
+    // handle fails, after max_age as a safety net, and at most every miss_interval when
+    // an unknown name is requested. Not thread safe, use it from one thread.
+    class session_registry_c
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        explicit session_registry_c(session_source_c &source,
+                                    std::chrono::milliseconds max_age = std::chrono::milliseconds(2000),
+                                    std::chrono::milliseconds miss_interval = std::chrono::milliseconds(250));
+
+        /// Brief: The cached sessions with their current volumes.
+        std::vector<endpoint> get_endpoints();
+
+        /// Brief: Set the volume of every session of a process.
+        /// param[in] name: Executable name, matched case-insensitively.
+        /// returns: APPLIED if at least one session was updated, NOT_FOUND if the process has none.
+        ApplyResult set_volume(std::string const &name, float volume);
+
+        /// Brief: Set the volume of every session the matcher assigns to an endpoint.
+        /// param[in] group: Index of the endpoint, see endpoint_matcher_c::match.
+        /// returns: APPLIED if at least one session was updated, NOT_FOUND if the group has none.
+        ApplyResult set_group_volume(size_t group, float volume);
+
+        // Resolve sessions to endpoint groups with this matcher from now on
+        void set_matcher(std::shared_ptr<endpoint_matcher_c const> matcher);
+
+        // Force a rebuild on the next lookup, e.g. after the default device changed
+        void invalidate();
+
+        // Number of session list rebuilds
+        uint64_t refresh_count() const { return m_refreshes; }
+
+        // Number of process name lookups passed to the source
+        uint64_t name_lookup_count() const { return m_name_lookups; }
+
+    private:
+        struct cached_session
+        {
+            std::string name;
+            uint32_t pid;
+            std::shared_ptr<session_volume_c> volume;
+        };
+
+        struct process
+        {
+            std::string name;
+            int group;
+        };
+
+        void refresh_if_stale(clock::time_point now);
+        void refresh(clock::time_point now);
+        ApplyResult apply(std::vector<size_t> const &indexes, float volume);
+
+        session_source_c &m_source;
+        clock::duration m_max_age;
+        clock::duration m_miss_interval;
+
+        std::vector<cached_session> m_sessions;
+        // Process name -> m_sessions indexes, searched case-insensitively
+        std::unordered_map<std::string, std::vector<size_t>, case_fold_hash, case_fold_equal> m_by_name;
+        std::vector<std::vector<size_t>> m_by_group;       // Endpoint group -> m_sessions indexes
+        std::unordered_map<uint32_t, process> m_processes; // Pids that own a session
+        std::shared_ptr<endpoint_matcher_c const> m_matcher;
+
+        bool m_valid;
+        uint64_t m_generation;
+        clock::time_point m_refreshed;
+        uint64_t m_refreshes;
+        uint64_t m_name_lookups;
+    };
+
+} // namespace audio_mixer
+
+#endif // __SESSION_REGISTRY__HPP__
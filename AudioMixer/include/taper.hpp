@@ -0,0 +1,55 @@
+#ifndef __TAPER__HPP__
+#define __TAPER__HPP__
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace audio_mixer
+{
+    enum class Taper : uint8_t
+    {
+        LINEAR,      // Volume follows the knob position
+        LOGARITHMIC, // -60 dB at the bottom to 0 dB at the top, muted at zero
+        S_CURVE,     // Fine control at both ends, coarse in the middle
+        CUSTOM       // Piecewise linear through points from the config
+    };
+
+    /// Brief: Parse "linear", "log", "logarithmic", "db", "s-curve" or "custom".
+    /// returns: False if the name is unknown, taper is left untouched.
+    bool parse_taper(std::string const &name, Taper &taper);
+
+    // Maps a knob reading to a volume through a lookup table.
+    //
+    // The built-in curves are generated at compile time for 10 and 12 bit
+    // readings, so scaling is one table load per knob. Other resolutions, e.g.
+    // 16 bit, interpolate the 12-bit table. Copies share the custom tables.
+    class taper_c
+    {
+    public:
+        taper_c();
+
+        /// Brief: Use a built-in curve, CUSTOM falls back to LINEAR, see set_custom.
+        void set_curve(Taper taper);
+
+        /// Brief: Use a curve through evenly spaced points.
+        /// param[in] points: Volumes from the bottom to the top end of the knob, at least two.
+        /// returns: False if there are fewer than two points, the taper is left untouched.
+        bool set_custom(std::vector<float> const &points);
+
+        /// Brief: Volume for a reading.
+        /// param[in] reading: Knob reading in ADC units, may be fractional after filtering.
+        /// param[in] bits: Resolution of the reading.
+        /// returns: Volume between 0.0 and 1.0.
+        float apply(float reading, uint8_t bits) const;
+
+    private:
+        float const *m_table10; // 1024 entries
+        float const *m_table12; // 4096 entries
+        std::shared_ptr<std::vector<float> const> m_custom; // Owns both tables of a custom curve
+    };
+
+} // namespace audio_mixer
+
+#endif // __TAPER__HPP__
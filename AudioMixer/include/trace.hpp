@@ -0,0 +1,156 @@
+#ifndef __TRACE__HPP__
+#define __TRACE__HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "frame_parser.hpp"
+
+namespace audio_mixer
+{
+    enum class TraceEvent : uint8_t
+    {
+        NONE,       // Slot never written
+        FRAME,      // Frame published by the serial reader, duration is the parse time
+        DISCARD,    // Malformed line or corrupt packet
+        HEARTBEAT,  // Heartbeat received
+        CONNECT,    // Serial session started
+        DISCONNECT, // Serial session ended
+        APPLY,      // Volume applied by the media worker, duration is the backend call
+        COUNT
+    };
+
+    // Knob values kept per FRAME record, further knobs are counted but not stored
+    constexpr size_t TRACE_KNOBS = 20;
+
+    // First bytes of a trace file, the records follow.
+    struct trace_header
+    {
+        char magic[8];            // "AMTRACE\0"
+        uint32_t version;         // TRACE_VERSION
+        uint32_t record_size;     // sizeof(trace_record)
+        uint64_t capacity;        // Number of record slots
+        int64_t wall_start_ns;    // System clock when the file was opened, ns since the epoch
+        uint64_t steady_start_ns; // Steady clock at the same moment, record times use this clock
+        uint8_t reserved[24];
+    };
+
+    // One event, written in place in the ring.
+    struct trace_record
+    {
+        uint64_t sequence;    // Position + 1, 0 while the slot is written
+        uint64_t time_ns;     // Steady clock, see pipeline_latency_c::now_ns
+        uint32_t duration_ns; // Event specific, saturates at ~4.3 s
+        TraceEvent type;
+        uint8_t endpoint;     // APPLY
+        uint8_t result;       // APPLY, an ApplyResult
+        uint8_t count;        // FRAME, knobs in the frame
+        uint16_t values[TRACE_KNOBS];
+    };
+
+    constexpr uint32_t TRACE_VERSION = 1;
+    constexpr char TRACE_MAGIC[8] = {'A', 'M', 'T', 'R', 'A', 'C', 'E', '\0'};
+
+    static_assert(sizeof(trace_header) == 64, "trace header layout");
+    static_assert(sizeof(trace_record) == 64, "one cache line per trace record");
+
+    // Optional binary trace of serial frames and volume applications.
+    //
+    // Records go into a ring of fixed-size slots in a memory mapped file: a slot
+    // is claimed with one atomic increment and filled with plain stores, no
+    // locks, system calls or formatting, so the trace can stay on at full frame
+    // rate. The kernel writes the pages back, so the trace survives a crash of
+    // the process. Any thread may write. Decode it with tools/trace_decoder.
+    class trace_c
+    {
+    public:
+        static trace_c &instance()
+        {
+            static trace_c inst;
+            return inst;
+        }
+
+        /// Brief: Start tracing into a file, a previous trace at the path is kept as <path>.prev.
+        /// param[in] path: Trace file, created or replaced.
+        /// param[in] capacity: Number of records before the oldest are overwritten.
+        /// returns: False if the file cannot be created or mapped, tracing stays off.
+        bool open(std::string const &path, size_t capacity);
+
+        // Stop tracing and unmap the file, only once no thread writes any more.
+        // Without it the OS writes the mapping back at exit.
+        void close();
+
+        bool enabled() const { return m_records.load(std::memory_order_acquire) != nullptr; }
+
+        // A frame as published by the serial reader
+        void frame(knob_frame const &frame, uint64_t time_ns, uint64_t duration_ns)
+        {
+            write(TraceEvent::FRAME, time_ns, duration_ns, 0, 0, frame.count, frame.values.data());
+        }
+
+        // A volume written by the backend
+        void apply(size_t endpoint, uint8_t result, uint64_t time_ns, uint64_t duration_ns)
+        {
+            write(TraceEvent::APPLY, time_ns, duration_ns, endpoint, result, 0, nullptr);
+        }
+
+        // An event without data
+        void event(TraceEvent type, uint64_t time_ns)
+        {
+            write(type, time_ns, 0, 0, 0, 0, nullptr);
+        }
+
+    private:
+        trace_c();
+
+        trace_c(trace_c const &) = delete;
+        trace_c &operator=(trace_c const &) = delete;
+
+        void write(TraceEvent type, uint64_t time_ns, uint64_t duration_ns, size_t endpoint, uint8_t result,
+                   uint16_t count, uint16_t const *values)
+        {
+            trace_record *records = m_records.load(std::memory_order_acquire);
+            if (records == nullptr)
+            {
+                return;
+            }
+            uint64_t const position = m_next.fetch_add(1, std::memory_order_relaxed);
+            trace_record &record = records[position % m_capacity];
+
+            // A record torn by a crash keeps sequence 0 and is skipped by the decoder
+            record.sequence = 0;
+            std::atomic_thread_fence(std::memory_order_release);
+            record.time_ns = time_ns;
+            record.duration_ns = static_cast<uint32_t>(std::min<uint64_t>(duration_ns, UINT32_MAX));
+            record.type = type;
+            record.endpoint = static_cast<uint8_t>(endpoint);
+            record.result = result;
+            record.count = static_cast<uint8_t>(std::min<uint16_t>(count, UINT8_MAX));
+            size_t const stored = values != nullptr ? std::min<size_t>(count, TRACE_KNOBS) : 0;
+            if (stored != 0)
+            {
+                std::memcpy(record.values, values, stored * sizeof(uint16_t));
+            }
+            std::memset(record.values + stored, 0, (TRACE_KNOBS - stored) * sizeof(uint16_t));
+            std::atomic_thread_fence(std::memory_order_release);
+            record.sequence = position + 1;
+        }
+
+        std::atomic<trace_record *> m_records;
+        size_t m_capacity;
+        alignas(64) std::atomic<uint64_t> m_next;
+        void *m_mapping;
+        size_t m_mapping_size;
+#ifdef _WIN32
+        void *m_file;
+        void *m_mapping_handle;
+#endif
+    };
+
+} // namespace audio_mixer
+
+#endif // __TRACE__HPP__
@@ -0,0 +1,79 @@
+#ifndef __VOLUME_DISPATCHER__HPP__
+#define __VOLUME_DISPATCHER__HPP__
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_parser.hpp"
+
+namespace audio_mixer
+{
+    // Decides which endpoints actually need a backend call.
+    //
+    // Keeps the last applied volume per endpoint and the newest target. Targets are
+    // quantized to a step, changes inside the dead-band are suppressed and every
+    // endpoint is called at most once per min_interval; a target that arrives
+    // sooner is held back and replaced by newer ones, so only the latest is applied
+    // once the interval has passed. Changes that fail are retried with the next
+    // target rather than polled. Mixer thread only.
+    class volume_dispatcher_c
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        volume_dispatcher_c();
+
+        /// Brief: Reset all endpoints and apply new settings, the counters keep running.
+        /// param[in] step: Volume quantization step, 0 to disable.
+        /// param[in] dead_band: Smallest change worth a backend call.
+        /// param[in] min_interval: Minimum time between two calls for the same endpoint.
+        void configure(float step, float dead_band, std::chrono::milliseconds min_interval);
+
+        /// Brief: Set the newest volume for an endpoint.
+        /// returns: The quantized target.
+        float set_target(size_t index, float volume);
+
+        // Quantized target of an endpoint
+        float target(size_t index) const { return m_targets[index]; }
+
+        // Bitmask of the endpoints that have a pending change and may be called now
+        uint64_t due(clock::time_point now) const;
+
+        // Earliest moment a held back change becomes due, clock::time_point::max() if none
+        clock::time_point next_due() const;
+
+        // Report a backend call, applied is false if the backend could not set it
+        void record_call(size_t index, bool applied, clock::time_point now);
+
+        // Forget the applied volume after a call failed asynchronously, the next target is sent again
+        void forget(size_t index);
+
+        // Backend calls made
+        uint64_t issued_count() const { return m_issued; }
+
+        // Targets dropped because they did not differ from the applied volume
+        uint64_t suppressed_count() const { return m_suppressed; }
+
+        // Targets replaced by a newer one while held back by the rate limit
+        uint64_t coalesced_count() const { return m_coalesced; }
+
+    private:
+        float quantize(float volume) const;
+
+        float m_step;
+        float m_dead_band;
+        clock::duration m_min_interval;
+        std::array<float, AUDIO_MIXER_MAX_KNOBS> m_targets;
+        std::array<float, AUDIO_MIXER_MAX_KNOBS> m_applied; // -1 until the first successful call
+        std::array<clock::time_point, AUDIO_MIXER_MAX_KNOBS> m_last_call;
+        uint64_t m_pending; // Bitmask of endpoints whose target still needs a call
+        uint64_t m_issued;
+        uint64_t m_suppressed;
+        uint64_t m_coalesced;
+    };
+
+} // namespace audio_mixer
+
+#endif // __VOLUME_DISPATCHER__HPP__
@@ -0,0 +1,74 @@
+#ifndef __VOLUME_RAMP__HPP__
+#define __VOLUME_RAMP__HPP__
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "frame_parser.hpp"
+
+namespace audio_mixer
+{
+    enum class RampMode : uint8_t
+    {
+        NONE,       // Jump straight to the knob value
+        LINEAR,     // Reach the knob value after the ramp time
+        EXPONENTIAL // Approach the knob value with the ramp time as time constant
+    };
+
+    /// Brief: Parse "none", "linear" or "exponential".
+    /// returns: False if the name is unknown, mode is left untouched.
+    bool parse_ramp_mode(std::string const &name, RampMode &mode);
+
+    // Smooths knob jumps into ramps so volumes do not step audibly.
+    //
+    // Goals can change at any rate, but ramps only move on a fixed tick, so the
+    // number of backend writes per ramp is bounded by ramp time / tick no matter
+    // how fast frames arrive. Endpoints without a ramp pass straight through.
+    // Mixer thread only.
+    class volume_ramp_c
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        volume_ramp_c();
+
+        /// Brief: Reset every endpoint and set the ramp tick.
+        void configure(std::chrono::milliseconds tick);
+
+        /// Brief: Set how an endpoint ramps.
+        /// param[in] time: Ramp duration for LINEAR, time constant for EXPONENTIAL.
+        void set_mode(size_t index, RampMode mode, std::chrono::milliseconds time);
+
+        /// Brief: Set the volume an endpoint should ramp to.
+        void set_goal(size_t index, float goal, clock::time_point now);
+
+        /// Brief: Move the ramps if a tick is due.
+        /// returns: Bitmask of the endpoints whose value changed since the last call.
+        uint64_t advance(clock::time_point now);
+
+        // Current, smoothed volume of an endpoint
+        float value(size_t index) const { return m_values[index]; }
+
+        // When advance() has work next, clock::time_point::max() if no ramp is running
+        clock::time_point next_tick() const;
+
+    private:
+        clock::duration m_tick;
+        clock::time_point m_next_tick;
+        std::array<RampMode, AUDIO_MIXER_MAX_KNOBS> m_modes;
+        std::array<float, AUDIO_MIXER_MAX_KNOBS> m_times; // Seconds
+        std::array<float, AUDIO_MIXER_MAX_KNOBS> m_goals;
+        std::array<float, AUDIO_MIXER_MAX_KNOBS> m_starts;
+        std::array<float, AUDIO_MIXER_MAX_KNOBS> m_values;
+        std::array<clock::time_point, AUDIO_MIXER_MAX_KNOBS> m_start_times;
+        uint64_t m_known;   // Endpoints that have a value, the first goal is taken without a ramp
+        uint64_t m_active;  // Endpoints that are ramping
+        uint64_t m_updated; // Endpoints whose value changed since the last advance()
+    };
+
+} // namespace audio_mixer
+
+#endif // __VOLUME_RAMP__HPP__
@@ -2,6 +2,7 @@
 #define __MEDIA_INTERFACE__HPP__
 
 #include <algorithm>
+#include <atomic>
 #include <audiopolicy.h>
 #include <endpointvolume.h>
 #include <iostream>
@@ -16,6 +17,7 @@
 
 #include "logger.hpp"
 #include "os_media_interface.hpp"
+#include "session_registry.hpp"
 
 namespace audio_mixer
 {
@@ -30,7 +32,8 @@ namespace audio_mixer
 
         void init()
         {
-            HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+            // Session notifications are only delivered to multithreaded apartments
+            HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
 
             if (hr == S_FALSE)
             {
@@ -58,7 +61,96 @@ namespace audio_mixer
         bool m_initialized;
     };
 
-    class windows_media_interface_c : public os_media_interface_c
+    // Volume of one audio session, muted instead of set to 0.
+    class windows_session_volume_c : public session_volume_c
+    {
+    public:
+        explicit windows_session_volume_c(Microsoft::WRL::ComPtr<ISimpleAudioVolume> volume)
+            : m_volume(std::move(volume))
+        {
+        }
+
+        bool set_volume(float volume) override
+        {
+            if (volume == 0.0f)
+            {
+                return SUCCEEDED(m_volume->SetMute(TRUE, nullptr));
+            }
+
+            if (FAILED(m_volume->SetMasterVolume(volume, nullptr)))
+            {
+                return false;
+            }
+            // Unmute if muted
+            BOOL is_muted = FALSE;
+            HRESULT hr = m_volume->GetMute(&is_muted);
+            if (SUCCEEDED(hr) && is_muted)
+            {
+                hr = m_volume->SetMute(FALSE, nullptr);
+            }
+            return SUCCEEDED(hr);
+        }
+
+        bool get_volume(float &volume) override
+        {
+            return SUCCEEDED(m_volume->GetMasterVolume(&volume));
+        }
+
+    private:
+        Microsoft::WRL::ComPtr<ISimpleAudioVolume> m_volume;
+    };
+
+    // Bumps a generation counter whenever the session manager reports a new session.
+    class session_notification_c : public IAudioSessionNotification
+    {
+    public:
+        explicit session_notification_c(std::shared_ptr<std::atomic<uint64_t>> generation)
+            : m_refs(1),
+              m_generation(std::move(generation))
+        {
+        }
+
+        ULONG STDMETHODCALLTYPE AddRef() override
+        {
+            return InterlockedIncrement(&m_refs);
+        }
+
+        ULONG STDMETHODCALLTYPE Release() override
+        {
+            ULONG refs = InterlockedDecrement(&m_refs);
+            if (refs == 0)
+            {
+                delete this;
+            }
+            return refs;
+        }
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **object) override
+        {
+            if (riid == __uuidof(IUnknown) || riid == __uuidof(IAudioSessionNotification))
+            {
+                *object = static_cast<IAudioSessionNotification *>(this);
+                AddRef();
+                return S_OK;
+            }
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        HRESULT STDMETHODCALLTYPE OnSessionCreated(IAudioSessionControl *) override
+        {
+            m_generation->fetch_add(1, std::memory_order_relaxed);
+            return S_OK;
+        }
+
+    private:
+        virtual ~session_notification_c() = default;
+
+        LONG m_refs;
+        std::shared_ptr<std::atomic<uint64_t>> m_generation;
+    };
+
+    class windows_media_interface_c : public os_media_interface_c, private session_source_c
     {
     public:
         void initialize()
@@ -74,6 +166,8 @@ namespace audio_mixer
             , m_sessionManager(nullptr)
             , m_endpointVolume(nullptr)
             , m_com()
+            , m_session_generation(std::make_shared<std::atomic<uint64_t>>(0))
+            , m_sessions(*this)
         {
             this->initialize();
 
@@ -101,6 +195,7 @@ namespace audio_mixer
                 audio_mixer::log_error("Failed to activate audio session manager.");
                 throw std::runtime_error("Failed to activate audio session manager");
             }
+            register_session_notification();
 
             // Activate IAudioEndpointVolume interface to control volume
             hr = m_device->Activate(__uuidof(IAudioEndpointVolume), CLSCTX_ALL, nullptr, &m_endpointVolume);
@@ -114,6 +209,7 @@ namespace audio_mixer
         // Destructor cleans up resources properly
         ~windows_media_interface_c()
         {
+            unregister_session_notification();
         }
 
         // Set the master volume control
@@ -126,25 +222,7 @@ namespace audio_mixer
             }
 
             ensure_default_device();
-
-            if (!m_endpointVolume)
-            {
-                // Activate and cache the endpoint volume interface
-                HRESULT hr = m_device->Activate(
-                    __uuidof(IAudioEndpointVolume), CLSCTX_ALL,
-                    nullptr, reinterpret_cast<void **>(m_endpointVolume.GetAddressOf()));
-                if (FAILED(hr))
-                {
-                    audio_mixer::log_error("Failed to activate IAudioEndpointVolume interface.");
-                    return;
-                }
-            }
-
-            HRESULT hr = m_endpointVolume->SetMasterVolumeLevelScalar(volume_level, nullptr);
-            if (FAILED(hr))
-            {
-                audio_mixer::log_error("Failed to set master volume.");
-            }
+            apply_master_volume(volume_level);
         }
 
         // List application volumes and process IDs
@@ -152,76 +230,12 @@ namespace audio_mixer
         {
             ensure_default_device();
 
-            std::vector<endpoint> appVolumeMap;
             if (!m_sessionManager)
             {
                 audio_mixer::log_error("Session manager not initialized.");
-                return appVolumeMap;
+                return {};
             }
-
-            Microsoft::WRL::ComPtr<IAudioSessionEnumerator> pSessionEnumerator;
-            HRESULT hr = m_sessionManager->GetSessionEnumerator(&pSessionEnumerator);
-            if (FAILED(hr))
-            {
-                audio_mixer::log_error("Failed to get session enumerator.");
-                return appVolumeMap;
-            }
-
-            int sessionCount = 0;
-            hr = pSessionEnumerator->GetCount(&sessionCount);
-            if (FAILED(hr))
-            {
-                audio_mixer::log_error("Failed to get session count.");
-                return appVolumeMap;
-            }
-
-            for (int i = 0; i < sessionCount; ++i)
-            {
-                Microsoft::WRL::ComPtr<IAudioSessionControl> pSessionControl;
-                hr = pSessionEnumerator->GetSession(i, &pSessionControl);
-                if (FAILED(hr) || !pSessionControl)
-                    continue;
-
-                Microsoft::WRL::ComPtr<IAudioSessionControl2> pSessionControl2;
-                hr = pSessionControl->QueryInterface(
-                    __uuidof(IAudioSessionControl2), reinterpret_cast<void **>(pSessionControl2.GetAddressOf()));
-                if (FAILED(hr) || !pSessionControl2)
-                    continue;
-
-                DWORD processId = 0;
-                hr = pSessionControl2->GetProcessId(&processId);
-                if (FAILED(hr) || processId == 0)
-                    continue;
-
-                HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, processId);
-                std::string processName = "<unknown>";
-                if (hProcess)
-                {
-                    wchar_t process_name[MAX_PATH] = L"<Unknown>";
-                    if (K32GetProcessImageFileNameW(hProcess, process_name, MAX_PATH))
-                    {
-                        processName = wide_char_proc_to_executable(process_name);
-                    }
-                    CloseHandle(hProcess);
-                }
-
-                Microsoft::WRL::ComPtr<ISimpleAudioVolume> pSimpleVolume;
-                hr = pSessionControl2->QueryInterface(
-                    __uuidof(ISimpleAudioVolume), reinterpret_cast<void **>(pSimpleVolume.GetAddressOf()));
-                if (FAILED(hr) || !pSimpleVolume)
-                    continue;
-
-                float volume = 0.0f;
-                hr = pSimpleVolume->GetMasterVolume(&volume);
-                if (FAILED(hr))
-                    continue;
-
-                endpoint app(processName);
-                app.current_volume = volume;
-                app.pid = static_cast<uint32_t>(processId);
-                appVolumeMap.emplace_back(app);
-            }
-            return appVolumeMap;
+            return m_sessions.get_endpoints();
         }
 
         // Set the volume for a specific application
@@ -240,97 +254,57 @@ namespace audio_mixer
                 return false;
             }
 
-            Microsoft::WRL::ComPtr<IAudioSessionEnumerator> pSessionEnumerator;
-            HRESULT hr = m_sessionManager->GetSessionEnumerator(&pSessionEnumerator);
-            if (FAILED(hr))
-            {
-                audio_mixer::log_error("Failed to get session enumerator.");
-                return false;
-            }
-
-            int sessionCount = 0;
-            hr = pSessionEnumerator->GetCount(&sessionCount);
-            if (FAILED(hr))
+            ApplyResult result = m_sessions.set_volume(app.name, app.set_volume);
+            if (result == ApplyResult::NOT_FOUND)
             {
-                audio_mixer::log_error("Failed to get session count.");
-                return false;
+                audio_mixer::log_error("No session found for " + app.name);
             }
+            return result == ApplyResult::APPLIED;
+        }
 
-            bool found = false;
-            for (int i = 0; i < sessionCount; ++i)
-            {
-                Microsoft::WRL::ComPtr<IAudioSessionControl> pSessionControl;
-                hr = pSessionEnumerator->GetSession(i, &pSessionControl);
-                if (FAILED(hr) || !pSessionControl)
-                    continue;
-
-                Microsoft::WRL::ComPtr<IAudioSessionControl2> pSessionControl2;
-                hr = pSessionControl->QueryInterface(
-                    __uuidof(IAudioSessionControl2), reinterpret_cast<void **>(pSessionControl2.GetAddressOf()));
-                if (FAILED(hr) || !pSessionControl2)
-                    continue;
+        // Resolve sessions to endpoint groups, cached per process by the registry
+        void set_matcher(std::shared_ptr<endpoint_matcher_c const> matcher) override
+        {
+            os_media_interface_c::set_matcher(matcher);
+            m_sessions.set_matcher(std::move(matcher));
+        }
 
-                DWORD sessionProcessId = 0;
-                hr = pSessionControl2->GetProcessId(&sessionProcessId);
-                if (FAILED(hr) || sessionProcessId == 0)
-                    continue; // skip system sounds
+        // Apply a batch, the default device and the session cache are checked once
+        std::vector<ApplyResult> set_volumes(std::vector<volume_change> const &changes) override
+        {
+            ensure_default_device();
 
-                HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, sessionProcessId);
-                std::string processName = "<unknown>";
-                if (hProcess)
+            std::vector<ApplyResult> results;
+            results.reserve(changes.size());
+            for (auto const &change : changes)
+            {
+                if (change.volume < 0.0f || change.volume > 1.0f)
                 {
-                    wchar_t process_name[MAX_PATH] = L"<Unknown>";
-                    if (K32GetProcessImageFileNameW(hProcess, process_name, MAX_PATH))
-                    {
-                        processName = wide_char_proc_to_executable(process_name);
-                    }
-                    CloseHandle(hProcess);
+                    audio_mixer::log_error("Volume must be between 0.0 and 1.0");
+                    results.emplace_back(ApplyResult::FAILED);
                 }
-
-                // Match by name (case-insensitive)
-                if (toLower(processName) == toLower(app.name))
+                else if (change.target->name == "master")
                 {
-                    Microsoft::WRL::ComPtr<ISimpleAudioVolume> pSimpleVolume;
-                    hr = pSessionControl2->QueryInterface(
-                        __uuidof(ISimpleAudioVolume), reinterpret_cast<void **>(pSimpleVolume.GetAddressOf()));
-                    if (FAILED(hr) || !pSimpleVolume)
-                        continue;
-
-                    if (app.set_volume == 0.0f)
-                    {
-                        hr = pSimpleVolume->SetMute(TRUE, nullptr);
-                        if (FAILED(hr))
-                        {
-                            audio_mixer::log_error("Failed to mute " + app.name);
-                        }
-                    }
-                    else
-                    {
-                        hr = pSimpleVolume->SetMasterVolume(app.set_volume, nullptr);
-                        if (FAILED(hr))
-                        {
-                            audio_mixer::log_error("Failed to set volume for " + app.name);
-                        }
-                        // Unmute if muted
-                        BOOL is_muted = FALSE;
-                        hr = pSimpleVolume->GetMute(&is_muted);
-                        if (SUCCEEDED(hr) && is_muted)
-                        {
-                            hr = pSimpleVolume->SetMute(FALSE, nullptr);
-                            if (FAILED(hr))
-                            {
-                                audio_mixer::log_error("Failed to unmute " + app.name);
-                            }
-                        }
-                    }
-                    found = true;
+                    apply_master_volume(change.volume);
+                    results.emplace_back(ApplyResult::APPLIED);
+                }
+                else if (change.target->name == "mic")
+                {
+                    set_microphone_volume(change.volume);
+                    results.emplace_back(ApplyResult::APPLIED);
+                }
+                else if (!m_sessionManager)
+                {
+                    results.emplace_back(ApplyResult::FAILED);
+                }
+                else
+                {
+                    // Applications that are not running are expected, the caller retries them
+                    results.emplace_back(m_matcher ? m_sessions.set_group_volume(change.index, change.volume)
+                                                   : m_sessions.set_volume(change.target->name, change.volume));
                 }
             }
-            if (!found)
-            {
-                audio_mixer::log_error("No session found for " + app.name);
-            }
-            return found;
+            return results;
         }
 
         // Set an audio input volume
@@ -408,6 +382,134 @@ namespace audio_mixer
         Microsoft::WRL::ComPtr<IAudioSessionManager2> m_sessionManager;
         Microsoft::WRL::ComPtr<IAudioEndpointVolume> m_endpointVolume;
         std::string m_currentDeviceId;
+        Microsoft::WRL::ComPtr<session_notification_c> m_sessionNotification;
+        std::shared_ptr<std::atomic<uint64_t>> m_session_generation; // Shared with the notification callback
+        session_registry_c m_sessions;
+
+        // Set the master volume on the current default device
+        void apply_master_volume(float volume_level)
+        {
+            if (!m_endpointVolume)
+            {
+                // Activate and cache the endpoint volume interface
+                HRESULT hr = m_device->Activate(
+                    __uuidof(IAudioEndpointVolume), CLSCTX_ALL,
+                    nullptr, reinterpret_cast<void **>(m_endpointVolume.GetAddressOf()));
+                if (FAILED(hr))
+                {
+                    audio_mixer::log_error("Failed to activate IAudioEndpointVolume interface.");
+                    return;
+                }
+            }
+
+            HRESULT hr = m_endpointVolume->SetMasterVolumeLevelScalar(volume_level, nullptr);
+            if (FAILED(hr))
+            {
+                audio_mixer::log_error("Failed to set master volume.");
+            }
+        }
+
+        // session_source_c: raw session access for the registry
+        std::vector<audio_session> enumerate_sessions() override
+        {
+            std::vector<audio_session> sessions;
+            if (!m_sessionManager)
+            {
+                return sessions;
+            }
+
+            Microsoft::WRL::ComPtr<IAudioSessionEnumerator> pSessionEnumerator;
+            HRESULT hr = m_sessionManager->GetSessionEnumerator(&pSessionEnumerator);
+            if (FAILED(hr))
+            {
+                audio_mixer::log_error("Failed to get session enumerator.");
+                return sessions;
+            }
+
+            int sessionCount = 0;
+            hr = pSessionEnumerator->GetCount(&sessionCount);
+            if (FAILED(hr))
+            {
+                audio_mixer::log_error("Failed to get session count.");
+                return sessions;
+            }
+
+            for (int i = 0; i < sessionCount; ++i)
+            {
+                Microsoft::WRL::ComPtr<IAudioSessionControl> pSessionControl;
+                hr = pSessionEnumerator->GetSession(i, &pSessionControl);
+                if (FAILED(hr) || !pSessionControl)
+                    continue;
+
+                AudioSessionState state = AudioSessionStateInactive;
+                if (SUCCEEDED(pSessionControl->GetState(&state)) && state == AudioSessionStateExpired)
+                    continue;
+
+                Microsoft::WRL::ComPtr<IAudioSessionControl2> pSessionControl2;
+                hr = pSessionControl->QueryInterface(
+                    __uuidof(IAudioSessionControl2), reinterpret_cast<void **>(pSessionControl2.GetAddressOf()));
+                if (FAILED(hr) || !pSessionControl2)
+                    continue;
+
+                DWORD processId = 0;
+                hr = pSessionControl2->GetProcessId(&processId);
+                if (FAILED(hr) || processId == 0)
+                    continue; // skip system sounds
+
+                Microsoft::WRL::ComPtr<ISimpleAudioVolume> pSimpleVolume;
+                hr = pSessionControl2->QueryInterface(
+                    __uuidof(ISimpleAudioVolume), reinterpret_cast<void **>(pSimpleVolume.GetAddressOf()));
+                if (FAILED(hr) || !pSimpleVolume)
+                    continue;
+
+                sessions.push_back(audio_session{
+                    static_cast<uint32_t>(processId), std::make_shared<windows_session_volume_c>(pSimpleVolume)});
+            }
+            return sessions;
+        }
+
+        std::string process_name(uint32_t pid) override
+        {
+            std::string processName;
+            HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, pid);
+            if (hProcess)
+            {
+                wchar_t process_name[MAX_PATH] = L"<Unknown>";
+                if (K32GetProcessImageFileNameW(hProcess, process_name, MAX_PATH))
+                {
+                    processName = wide_char_proc_to_executable(process_name);
+                }
+                CloseHandle(hProcess);
+            }
+            return processName;
+        }
+
+        uint64_t session_generation() const override
+        {
+            return m_session_generation->load(std::memory_order_relaxed);
+        }
+
+        // New sessions bump the generation, so the registry only walks sessions when needed
+        void register_session_notification()
+        {
+            m_sessionNotification.Attach(new session_notification_c(m_session_generation));
+            HRESULT hr = m_sessionManager->RegisterSessionNotification(m_sessionNotification.Get());
+            if (FAILED(hr))
+            {
+                // The registry still rebuilds on misses and failures
+                audio_mixer::log_warning("Failed to register for audio session notifications.");
+                m_sessionNotification.Reset();
+            }
+        }
+
+        void unregister_session_notification()
+        {
+            if (m_sessionManager && m_sessionNotification)
+            {
+                m_sessionManager->UnregisterSessionNotification(m_sessionNotification.Get());
+            }
+            m_sessionNotification.Reset();
+        }
 
         std::string wide_char_proc_to_executable(const wchar_t *wideStr)
         {
@@ -455,6 +557,8 @@ namespace audio_mixer
             if (newId != m_currentDeviceId)
             {
                 // Reinitialize everything
+                unregister_session_notification();
+                m_sessions.invalidate();
                 m_device.Reset();
                 m_sessionManager.Reset();
                 m_endpointVolume.Reset();
@@ -465,6 +569,7 @@ namespace audio_mixer
                 hr = m_device->Activate(__uuidof(IAudioSessionManager2), CLSCTX_ALL, nullptr, &m_sessionManager);
                 if (FAILED(hr))
                     return;
+                register_session_notification();
                 hr = m_device->Activate(__uuidof(IAudioEndpointVolume), CLSCTX_ALL, nullptr, &m_endpointVolume);
                 if (FAILED(hr))
                     return;
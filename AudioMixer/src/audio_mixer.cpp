@@ -1,22 +1,79 @@
 
 #include "audio_mixer.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <filesystem>
-#include <yaml-cpp/yaml.h>
 
 #include "logger.hpp"
+#include "metrics.hpp"
+#include "pipeline_latency.hpp"
+#include "trace.hpp"
 
 namespace audio_mixer
 {
+    namespace
+    {
+        // How long an idle EVENT mode loop sleeps before re-checking the exit flag and for a reloaded config.
+        constexpr std::chrono::milliseconds EXIT_CHECK_INTERVAL(1000);
+        // How often the latency histograms are written to the debug log.
+        constexpr std::chrono::minutes LATENCY_REPORT_INTERVAL(5);
+        // Editors save in several steps or replace the file, reload once it settled.
+        constexpr std::chrono::milliseconds RELOAD_SETTLE_TIME(200);
+        // How often the config file's modification time is checked without change notifications.
+        constexpr std::chrono::seconds CONFIG_POLL_INTERVAL(2);
+
+        // Relative paths in config.yaml start at the config file
+        std::string config_relative(std::string const &config_path, std::string const &file)
+        {
+            std::filesystem::path path(file);
+            if (path.is_relative())
+            {
+                path = std::filesystem::path(config_path).parent_path() / path;
+            }
+            return path.string();
+        }
+
+        // config.yaml next to the executable
+        std::string default_config_path()
+        {
+            // Find path to executable
+            std::string exe_path;
+#ifdef _WIN32
+            char exePath[MAX_PATH];
+            GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+            exe_path = exePath;
+            exe_path = exe_path.substr(0, exe_path.find_last_of("\\/") + 1);
+#else
+            exe_path = "./";
+#endif
+            return exe_path + "config.yaml";
+        }
+    } // namespace
 
     audio_mixer_c::audio_mixer_c(boost::asio::io_context &context)
+        : audio_mixer_c(context, default_config_path(), create_media_interface())
+    {
+    }
+
+    audio_mixer_c::audio_mixer_c(boost::asio::io_context &context, std::string const &config_path,
+                                 std::unique_ptr<os_media_interface_c> media)
         : m_context(context),
-          m_data_stack(std::make_shared<stack_c>()),
-          m_num_of_knobs(5),
+          m_frames(std::make_shared<frame_mailbox_c>()),
+          m_worker(media ? std::make_unique<media_worker_c>(std::move(media)) : nullptr),
+          m_config_path(config_path),
           m_baud_rate(9600U),
-          m_data_rate_ms(50U)
+          m_filter_tick(volume_ramp_c::clock::time_point::max()),
+          m_config_changed(false),
+          m_config_watcher(context),
+          m_reload_timer(context)
     {
         load_configs();
+        m_baud_rate = baud_rate_t(m_published->baud_rate);
+        open_trace();
+        start_metrics();
+        apply_config();
+        watch_config();
 
         // Start the context
         std::thread con_thread(
@@ -30,58 +87,180 @@ namespace audio_mixer
 
     void audio_mixer_c::load_configs()
     {
-        // Find path to executable
-        std::string exe_path;
-#ifdef _WIN32
-        char exePath[MAX_PATH];
-        GetModuleFileNameA(nullptr, exePath, MAX_PATH);
-        exe_path = exePath;
-        exe_path = exe_path.substr(0, exe_path.find_last_of("\\/") + 1);
-#else
-        exe_path = "./";
-#endif
-        std::string config_path = exe_path + "config.yaml";
-
+        std::shared_ptr<mixer_config const> config;
         try
         {
-            YAML::Node config = YAML::LoadFile(config_path);
-
-            m_num_of_knobs = config["num_of_knobs"].as<uint16_t>(5);
-            m_baud_rate = baud_rate_t(config["baud_rate"].as<uint32_t>(9600));
-            m_data_rate_ms = config["data_rate_ms"].as<uint16_t>(50);
+            // Parsing and compiling patterns happens here, the mixer only swaps the pointer
+            config = load_mixer_config(m_config_path);
+        }
+        catch (const std::exception &e)
+        {
+            audio_mixer::log_error(std::string("Failed to load config.yaml: ") + e.what());
+        }
 
-            m_endpoints.clear();
-            if (config["endpoints"])
+        std::lock_guard<std::mutex> lock(m_config_mutex);
+        if (!config)
+        {
+            if (m_published)
             {
-                for (const auto &ep : config["endpoints"])
-                {
-                    m_endpoints.emplace_back(endpoint(ep.as<std::string>()));
-                }
+                audio_mixer::log_warning("Keeping the current config");
+                return;
             }
-
-            for (auto &app : m_endpoints)
+            // Fallback to defaults if needed...
+            config = default_mixer_config();
+        }
+        else if (m_published)
+        {
+            if (config->baud_rate != m_published->baud_rate || config->trace_file != m_published->trace_file ||
+                config->trace_records != m_published->trace_records ||
+                config->metrics_socket != m_published->metrics_socket ||
+                config->metrics_textfile != m_published->metrics_textfile ||
+                config->metrics_interval != m_published->metrics_interval)
             {
-                audio_mixer::log_info("Loaded: " + app.name);
+                audio_mixer::log_warning("baud_rate, trace and metrics changes take effect after a restart");
             }
+            metrics_c::instance().add(Counter::CONFIG_RELOADS);
         }
-        catch (const std::exception &e)
+
+        for (auto &app : config->endpoints)
         {
-            audio_mixer::log_error(std::string("Failed to load config.yaml: ") + e.what());
-            // Fallback to defaults if needed...
-            m_endpoints.emplace_back(endpoint("master"));
+            audio_mixer::log_info("Loaded: " + app.name);
         }
+        m_published = std::move(config);
+        m_config_changed.store(true, std::memory_order_release);
+    }
 
-        m_data_pattern = create_regex(m_num_of_knobs);
+    void audio_mixer_c::open_trace()
+    {
+        if (m_published->trace_file.empty())
+        {
+            return;
+        }
+        trace_c::instance().open(config_relative(m_config_path, m_published->trace_file), m_published->trace_records);
     }
 
-    std::shared_ptr<stack_c> audio_mixer_c::get_data_stack() const
+    void audio_mixer_c::start_metrics()
     {
-        return this->m_data_stack;
+        // The mailbox counts on its own, read it only when the metrics are exported
+        auto &metrics = metrics_c::instance();
+        std::shared_ptr<frame_mailbox_c const> frames = m_frames;
+        metrics.add_source("audiomixer_mailbox_frames_published_total", "Frames published into the frame mailbox",
+                           [frames]() { return frames->published_count(); });
+        metrics.add_source("audiomixer_mailbox_frames_overwritten_total",
+                           "Frames replaced by a newer one before the mixer took them",
+                           [frames]() { return frames->overwritten_count(); });
+
+        auto const &config = *m_published;
+        if (config.metrics_socket.empty() && config.metrics_textfile.empty())
+        {
+            return;
+        }
+        m_metrics = std::make_unique<metrics_exporter_c>(m_context);
+        if (!config.metrics_socket.empty())
+        {
+            m_metrics->listen(config_relative(m_config_path, config.metrics_socket));
+        }
+        if (!config.metrics_textfile.empty())
+        {
+            m_metrics->write_textfile(config_relative(m_config_path, config.metrics_textfile),
+                                      config.metrics_interval);
+        }
+    }
+
+    void audio_mixer_c::watch_config()
+    {
+        std::filesystem::path const path(m_config_path);
+        std::string const directory = path.has_parent_path() ? path.parent_path().string() : ".";
+        std::string const name = path.filename().string();
+        // Editors write in place or replace the file, watch for both
+        bool const watching = m_config_watcher.start(
+            directory, directory_watcher_c::ENTRIES | directory_watcher_c::WRITES, [this, name](std::string const &entry, directory_watcher_c::Event event) {
+                if ((entry == name && event != directory_watcher_c::Event::REMOVED) ||
+                    event == directory_watcher_c::Event::RESCAN)
+                {
+                    schedule_reload();
+                }
+            });
+        if (!watching)
+        {
+            // No change notifications, compare the modification time instead
+            std::error_code error;
+            m_config_written = std::filesystem::last_write_time(path, error);
+            poll_config();
+        }
+    }
+
+    // Restarts the settle time on every event, so a burst of writes reloads once
+    void audio_mixer_c::schedule_reload()
+    {
+        m_reload_timer.expires_after(RELOAD_SETTLE_TIME);
+        m_reload_timer.async_wait(
+            [this](boost::system::error_code const &ec) {
+                if (!ec)
+                {
+                    audio_mixer::log_info("Config file changed, reloading");
+                    load_configs();
+                }
+            });
+    }
+
+    void audio_mixer_c::poll_config()
+    {
+        m_reload_timer.expires_after(CONFIG_POLL_INTERVAL);
+        m_reload_timer.async_wait(
+            [this](boost::system::error_code const &ec) {
+                if (ec)
+                {
+                    return;
+                }
+                std::error_code error;
+                auto const written = std::filesystem::last_write_time(m_config_path, error);
+                if (!error && written != m_config_written)
+                {
+                    m_config_written = written;
+                    audio_mixer::log_info("Config file changed, reloading");
+                    load_configs();
+                }
+                poll_config();
+            });
+    }
+
+    // Switch to the newest snapshot, runs on the mixer thread between two frames
+    void audio_mixer_c::apply_config()
+    {
+        m_config_changed.store(false, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(m_config_mutex);
+            m_config = m_published;
+        }
+
+        // Knobs may now control other endpoints, start every one of them over
+        auto const &config = *m_config;
+        m_dispatcher.configure(config.volume_step, config.dead_band, config.endpoint_min_interval);
+        m_filter.configure(config.filter_median, config.filter_min_cutoff_hz, config.filter_beta);
+        m_filter_tick = volume_ramp_c::clock::time_point::max();
+        m_ramp.configure(config.ramp_tick);
+        metrics_c::instance().set(Gauge::ENDPOINTS, static_cast<int64_t>(config.endpoints.size()));
+        size_t const count = std::min<size_t>(config.endpoints.size(), AUDIO_MIXER_MAX_KNOBS);
+        for (size_t i = 0; i < count; i++)
+        {
+            m_ramp.set_mode(i, config.ramp_modes[i], config.ramp_times[i]);
+        }
+
+        if (m_worker)
+        {
+            m_worker->configure(config.endpoints, config.matcher);
+        }
+    }
+
+    std::shared_ptr<frame_mailbox_c> audio_mixer_c::get_frame_mailbox() const
+    {
+        return this->m_frames;
     }
 
     uint16_t audio_mixer_c::get_data_rate() const
     {
-        return this->m_data_rate_ms;
+        return this->m_config->data_rate_ms;
     }
 
     audio_mixer_c::baud_rate_t audio_mixer_c::get_baud_rate() const
@@ -89,122 +268,241 @@ namespace audio_mixer
         return this->m_baud_rate;
     }
 
+    volume_dispatcher_c const &audio_mixer_c::get_dispatcher() const
+    {
+        return this->m_dispatcher;
+    }
+
     void audio_mixer_c::run(bool &exit_app)
     {
+        auto last_update = std::chrono::steady_clock::time_point{};
+        auto last_report = std::chrono::steady_clock::now();
         while (!exit_app)
         {
-            // Get data from serial
-            std::optional<std::string> data = m_data_stack->get_latest_match(m_data_pattern);
+            if (m_config->update_mode == UpdateMode::EVENT)
+            {
+                // Sleep until serial publishes a frame, a ramp tick or a rate limited volume
+                // change is due, otherwise the timeout only bounds exit and reload latency.
+                auto const now = std::chrono::steady_clock::now();
+                auto timeout = EXIT_CHECK_INTERVAL;
+                auto const next_due = next_wakeup();
+                if (next_due < now + timeout)
+                {
+                    // Already due means no wait at all, never a negative timeout
+                    timeout = std::max(std::chrono::duration_cast<std::chrono::milliseconds>(next_due - now) +
+                                           std::chrono::milliseconds(1),
+                                       std::chrono::milliseconds(0));
+                }
+                if (!m_frames->wait_for_unread(timeout))
+                {
+                    // Frames only come with knob changes or not at all, a reload must not wait for one
+                    if (m_config_changed.load(std::memory_order_acquire))
+                    {
+                        apply_config();
+                    }
+                    auto const woke = std::chrono::steady_clock::now();
+                    step_ramps(woke);
+                    dispatch(woke);
+                    continue;
+                }
+
+                // Coalesce bursts, frames arriving meanwhile overwrite each other in the mailbox.
+                auto next_update = last_update + m_config->min_update_interval;
+                if (std::chrono::steady_clock::now() < next_update)
+                {
+                    std::this_thread::sleep_until(next_update);
+                }
+            }
+
+            // A reloaded config takes over here, the check is a single load until one is published
+            if (m_config_changed.load(std::memory_order_acquire))
+            {
+                apply_config();
+            }
 
-            if (data)
+            // Get the newest frame from serial
+            knob_frame frame;
+            if (m_frames->take(frame))
             {
+                pipeline_latency_c::instance().record_since(Stage::PICKUP, frame.published_ns);
+
                 // Make a decision based on the data.
-                auto vals = extract_values(data.value());
-                if (vals.size() != static_cast<int>(m_num_of_knobs))
+                if (frame.count != m_config->num_of_knobs)
                 {
-                    audio_mixer::log_error(
-                        "knobs[" + std::to_string(m_num_of_knobs) + "] != vals[" + std::to_string(vals.size()) + "]");
-                    continue;
+                    metrics_c::instance().add(Counter::SIZE_MISMATCHES);
+                    AUDIO_MIXER_LOG_ERROR("knobs[", m_config->num_of_knobs, "] != vals[", frame.count, "]");
                 }
                 else
                 {
                     // Process the values
-                    update(vals);
+                    update(frame);
+                    last_update = std::chrono::steady_clock::now();
+                }
+            }
+            else if (m_config->update_mode == UpdateMode::POLL)
+            {
+                // Move ramps and flush changes held back by the rate limit
+                auto const now = std::chrono::steady_clock::now();
+                step_ramps(now);
+                dispatch(now);
+            }
+
+            if (m_config->update_mode == UpdateMode::POLL)
+            {
+                // Poll every data_rate_ms, ramp ticks and rate limited changes in between still go out on time
+                auto const next_poll =
+                    std::chrono::steady_clock::now() + std::chrono::milliseconds(m_config->data_rate_ms);
+                for (auto next_due = next_wakeup(); next_due < next_poll && !exit_app; next_due = next_wakeup())
+                {
+                    std::this_thread::sleep_until(next_due);
+                    auto const woke = std::chrono::steady_clock::now();
+                    step_ramps(woke);
+                    dispatch(woke);
                 }
+                std::this_thread::sleep_until(next_poll);
+            }
+
+            if (std::chrono::steady_clock::now() - last_report >= LATENCY_REPORT_INTERVAL)
+            {
+                last_report = std::chrono::steady_clock::now();
+                AUDIO_MIXER_LOG_DEBUG("Pipeline latency:\n", pipeline_latency_c::instance().summary(m_config->endpoints));
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(this->m_data_rate_ms)));
         }
+
+        audio_mixer::log_info("Frames published: " + std::to_string(m_frames->published_count()) +
+                              ", overwritten before use: " + std::to_string(m_frames->overwritten_count()));
+        audio_mixer::log_info("Volume calls issued: " + std::to_string(m_dispatcher.issued_count()) +
+                              ", suppressed: " + std::to_string(m_dispatcher.suppressed_count()) +
+                              ", coalesced: " + std::to_string(m_dispatcher.coalesced_count()));
+        if (m_worker)
+        {
+            audio_mixer::log_info("Backend batches: " + std::to_string(m_worker->batch_count()) +
+                                  ", writes replaced while queued: " + std::to_string(m_worker->replaced_count()));
+        }
+        audio_mixer::log_info("Pipeline latency:\n" + pipeline_latency_c::instance().summary(m_config->endpoints));
+    }
+
+    void audio_mixer_c::set_targets(knob_frame const &frame)
+    {
+        std::array<float, AUDIO_MIXER_MAX_KNOBS> readings;
+        m_filter.apply(frame, readings);
+        m_filtered = frame;
+        auto const now = std::chrono::steady_clock::now();
+        set_goals(readings, now);
+        // Without a backend there is nothing a settling filter could update
+        m_filter_tick = (m_worker && !m_filter.settled()) ? now + m_config->ramp_tick
+                                                          : volume_ramp_c::clock::time_point::max();
+        step_ramps(now);
     }
 
-    std::regex audio_mixer_c::create_regex(uint16_t count)
+    void audio_mixer_c::settle_filter(volume_ramp_c::clock::time_point now)
     {
-        // Accept any 1-4 digit number (0-1023 from Arduino)
-        std::string numberPattern = "(?:[0-9]{1,4})";
+        std::array<float, AUDIO_MIXER_MAX_KNOBS> readings;
+        m_filter.settle(static_cast<uint64_t>(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count()),
+                        readings);
+        set_goals(readings, now);
+        m_filter_tick = m_filter.settled() ? volume_ramp_c::clock::time_point::max() : now + m_config->ramp_tick;
+    }
 
-        std::string fullPattern = "^" + numberPattern;
-        for (int i = 1; i < count; ++i)
+    void audio_mixer_c::set_goals(std::array<float, AUDIO_MIXER_MAX_KNOBS> const &readings,
+                                  volume_ramp_c::clock::time_point now)
+    {
+        auto volumes = scale_values(m_filtered, readings);
+        // Assumes the volume and endpoints have corresponding indexes, knobs without one are ignored
+        size_t const count = std::min<size_t>(m_filtered.count, m_config->endpoints.size());
+        for (size_t i = 0; i < count; i++)
         {
-            fullPattern += "\\|" + numberPattern;
+            m_ramp.set_goal(i, volumes[i], now);
         }
-        fullPattern += "$";
+    }
 
-        return std::regex(fullPattern);
+    volume_ramp_c::clock::time_point audio_mixer_c::next_wakeup() const
+    {
+        auto const tick = std::min(m_ramp.next_tick(), m_filter_tick);
+        // Without a worker nothing is ever dispatched, so held back changes cannot be due
+        return m_worker ? std::min(m_dispatcher.next_due(), tick) : tick;
     }
 
-    std::vector<int> audio_mixer_c::extract_values(std::string &values)
+    void audio_mixer_c::step_ramps(volume_ramp_c::clock::time_point now)
     {
-        std::vector<int> result;
-        size_t pos = 0;
-        std::string token;
-        while ((pos = values.find('|')) != std::string::npos)
+        // A stopped knob sends no more frames, the filter catches up with its last reading here
+        if (now >= m_filter_tick)
+        {
+            settle_filter(now);
+        }
+        uint64_t const updated = m_ramp.advance(now);
+        if (!m_worker)
+        {
+            // No backend, keep no targets that only dispatch() could clear
+            return;
+        }
+        size_t const count = std::min<size_t>(m_config->endpoints.size(), AUDIO_MIXER_MAX_KNOBS);
+        for (size_t i = 0; i < count; i++)
         {
-            token = values.substr(0, pos);
-            result.emplace_back(std::atoi(token.c_str()));
-            values.erase(0, pos + 1);
+            if (updated & (uint64_t{1} << i))
+            {
+                m_dispatcher.set_target(i, m_ramp.value(i));
+            }
         }
-        result.emplace_back(std::atoi(values.c_str()));
-        return result;
     }
 
-    void audio_mixer_c::update_volumes(std::vector<int> const &values)
+    void audio_mixer_c::update(knob_frame const &frame)
     {
-        auto volumes = scale_values(values);
-        // Assumes the volume and endpoints have corresponding indexes
-        for (size_t i = 0; i < volumes.size(); i++)
+        auto &latency = pipeline_latency_c::instance();
+        uint64_t const scale_start = pipeline_latency_c::now_ns();
+        set_targets(frame);
+        uint64_t const apply_start = latency.record_since(Stage::SCALE, scale_start);
+
+        if (m_worker && m_dispatcher.due(std::chrono::steady_clock::now()) != 0)
         {
-            m_endpoints.at(i).set_volume = volumes.at(i);
+            dispatch(std::chrono::steady_clock::now(), frame.received_ns);
+            latency.record_since(Stage::APPLY, apply_start);
         }
     }
 
-    void audio_mixer_c::update(std::vector<int> const &values)
+    void audio_mixer_c::dispatch(volume_dispatcher_c::clock::time_point now, uint64_t received_ns)
     {
-        update_volumes(values);
+        if (!m_worker)
+        {
+            return;
+        }
 
-        // Get updated endpoints, filtering out ones that are not desired
-#ifdef _WIN32
-        auto available_endpoints = m_media.get_endpoints();
-        for (auto &avail_endpoint : available_endpoints)
+        // Writes the worker could not apply, e.g. the application is not running yet,
+        // are sent again with the next target
+        size_t const count = std::min<size_t>(m_config->endpoints.size(), AUDIO_MIXER_MAX_KNOBS);
+        uint64_t const failed = m_worker->take_failed();
+        for (size_t i = 0; i < count; i++)
         {
-            auto it = std::find(m_endpoints.begin(), m_endpoints.end(), avail_endpoint);
-            if (it != m_endpoints.end())
+            if (failed & (uint64_t{1} << i))
             {
-                it->name = avail_endpoint.name;
-                it->current_volume = avail_endpoint.current_volume;
+                m_dispatcher.forget(i);
             }
         }
 
-        for (auto &endpoint : m_endpoints)
+        // Everything due goes to the worker at once, so it is written in one backend batch
+        uint64_t const due = m_dispatcher.due(now);
+        std::array<float, AUDIO_MIXER_MAX_KNOBS> volumes{};
+        for (size_t i = 0; i < count; i++)
         {
-            if (endpoint.name == "master")
-            {
-                m_media.set_master_volume(endpoint.set_volume);
-            }
-            else if (endpoint.name == "mic")
-            {
-                // Support for mic input devices
-                m_media.set_microphone_volume(endpoint.set_volume); // untested
-            }
-            else if (std::find(available_endpoints.begin(), available_endpoints.end(), endpoint)
-                    != available_endpoints.end())
+            if (due & (uint64_t{1} << i))
             {
-                // Set the volume for the application
-                m_media.set_application_volume(endpoint);
+                volumes[i] = m_dispatcher.target(i);
+                m_dispatcher.record_call(i, true, now);
             }
         }
-#endif
-        // For debugging
-        std::this_thread::sleep_for(std::chrono::milliseconds(3));
+        m_worker->submit(due, volumes, received_ns);
     }
 
-    std::vector<float> audio_mixer_c::scale_values(std::vector<int> const &values)
+    std::array<float, AUDIO_MIXER_MAX_KNOBS> audio_mixer_c::scale_values(
+        knob_frame const &frame, std::array<float, AUDIO_MIXER_MAX_KNOBS> const &readings)
     {
-        std::vector<float> output;
-        output.reserve(values.size());
+        std::array<float, AUDIO_MIXER_MAX_KNOBS> output{};
 
-        for (int value : values)
+        for (size_t i = 0; i < frame.count; i++)
         {
-            // Normalize each value from [0, 1023] to [0.0, 1.0]
-            output.emplace_back(value / 1023.0f);
+            // One table load at the frame's own resolution
+            output[i] = m_config->tapers[i].apply(readings[i], frame.bits);
         }
 
         return output;
@@ -0,0 +1,134 @@
+#include "directory_watcher.hpp"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "logger.hpp"
+
+namespace audio_mixer
+{
+#ifdef __linux__
+    directory_watcher_c::directory_watcher_c(boost::asio::io_context &context)
+        : m_descriptor(context),
+          m_buffer{}
+    {
+    }
+
+    directory_watcher_c::~directory_watcher_c()
+    {
+        stop();
+    }
+
+    bool directory_watcher_c::start(std::string const &directory, uint32_t events, callback_t callback)
+    {
+        stop();
+
+        int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0)
+        {
+            audio_mixer::log_warning("inotify_init1 failed, falling back to polling " + directory);
+            return false;
+        }
+
+        uint32_t mask = 0;
+        if (events & ENTRIES)
+        {
+            mask |= IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM;
+        }
+        if (events & WRITES)
+        {
+            mask |= IN_CLOSE_WRITE;
+        }
+        if (inotify_add_watch(fd, directory.c_str(), mask) < 0)
+        {
+            audio_mixer::log_warning("Cannot watch " + directory + ", falling back to polling");
+            ::close(fd);
+            return false;
+        }
+
+        m_callback = std::move(callback);
+        m_descriptor.assign(fd);
+        start_read();
+        return true;
+    }
+
+    void directory_watcher_c::stop()
+    {
+        if (m_descriptor.is_open())
+        {
+            boost::system::error_code ec;
+            m_descriptor.close(ec);
+        }
+    }
+
+    void directory_watcher_c::start_read()
+    {
+        m_descriptor.async_read_some(
+            boost::asio::buffer(m_buffer),
+            [this](boost::system::error_code const &ec, std::size_t count)
+            {
+                if (ec)
+                {
+                    if (ec != boost::asio::error::operation_aborted)
+                    {
+                        audio_mixer::log_error("directory_watcher_c: read error: " + ec.message());
+                    }
+                    return;
+                }
+
+                // The kernel only returns whole events
+                size_t offset = 0;
+                while (offset + sizeof(inotify_event) <= count)
+                {
+                    auto const *event = reinterpret_cast<inotify_event const *>(m_buffer.data() + offset);
+                    offset += sizeof(inotify_event) + event->len;
+
+                    if (event->mask & IN_Q_OVERFLOW)
+                    {
+                        m_callback(std::string(), Event::RESCAN);
+                        continue;
+                    }
+                    if (event->len == 0)
+                    {
+                        continue;
+                    }
+
+                    std::string name(event->name);
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                    {
+                        m_callback(name, Event::ADDED);
+                    }
+                    else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                    {
+                        m_callback(name, Event::REMOVED);
+                    }
+                    else if (event->mask & IN_CLOSE_WRITE)
+                    {
+                        m_callback(name, Event::MODIFIED);
+                    }
+                }
+                start_read();
+            });
+    }
+#else
+    directory_watcher_c::directory_watcher_c(boost::asio::io_context &)
+    {
+    }
+
+    directory_watcher_c::~directory_watcher_c()
+    {
+    }
+
+    bool directory_watcher_c::start(std::string const &, uint32_t, callback_t)
+    {
+        return false;
+    }
+
+    void directory_watcher_c::stop()
+    {
+    }
+#endif
+
+} // namespace audio_mixer
@@ -0,0 +1,137 @@
+#include "endpoint_matcher.hpp"
+
+#include "logger.hpp"
+
+namespace audio_mixer
+{
+    namespace
+    {
+        bool is_device(endpoint const &ep)
+        {
+            return ep.applications.empty() && (ep.name == "master" || ep.name == "mic");
+        }
+
+        bool is_regex(std::string const &entry)
+        {
+            return entry.size() >= 2 && entry.front() == '/' && entry.back() == '/';
+        }
+
+        bool is_glob(std::string const &entry)
+        {
+            return entry.find_first_of("*?") != std::string::npos;
+        }
+
+        // Case-insensitive glob match, '*' matches any run and '?' one character.
+        // Backtracks to the last '*' only, so it is linear in practice.
+        bool glob_match(std::string_view glob, std::string_view text)
+        {
+            size_t g = 0;
+            size_t t = 0;
+            size_t star = std::string_view::npos;
+            size_t resume = 0;
+            while (t < text.size())
+            {
+                if (g < glob.size() && (glob[g] == '?' || glob[g] == fold_case(text[t])))
+                {
+                    g++;
+                    t++;
+                }
+                else if (g < glob.size() && glob[g] == '*')
+                {
+                    star = g++;
+                    resume = t;
+                }
+                else if (star != std::string_view::npos)
+                {
+                    g = star + 1;
+                    t = ++resume;
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            while (g < glob.size() && glob[g] == '*')
+            {
+                g++;
+            }
+            return g == glob.size();
+        }
+    } // namespace
+
+    bool endpoint_matcher_c::is_pattern(std::string const &entry)
+    {
+        return is_regex(entry) || is_glob(entry);
+    }
+
+    endpoint_matcher_c::endpoint_matcher_c(std::vector<endpoint> const &endpoints)
+        : m_size(endpoints.size())
+    {
+        for (size_t i = 0; i < endpoints.size(); i++)
+        {
+            auto const &ep = endpoints[i];
+            if (is_device(ep))
+            {
+                continue;
+            }
+
+            int const group = static_cast<int>(i);
+            std::vector<std::string> const single{ep.name};
+            for (auto const &entry : ep.applications.empty() ? single : ep.applications)
+            {
+                if (is_regex(entry))
+                {
+                    try
+                    {
+                        m_patterns.push_back(pattern{
+                            true, "", std::regex(entry.substr(1, entry.size() - 2), std::regex::icase), group});
+                    }
+                    catch (std::regex_error const &e)
+                    {
+                        audio_mixer::log_warning("Skipping invalid pattern " + entry + " of " + ep.name + ": " +
+                                                 e.what());
+                    }
+                }
+                else if (is_glob(entry))
+                {
+                    m_patterns.push_back(pattern{false, toLower(entry), std::regex(), group});
+                }
+                else if (m_exact.find(entry) == m_exact.end())
+                {
+                    m_exact.emplace(m_names.emplace_back(entry), group);
+                }
+                else
+                {
+                    audio_mixer::log_warning(entry + " is listed by more than one endpoint, the first is used");
+                }
+            }
+        }
+    }
+
+    int endpoint_matcher_c::match(std::string_view process_name) const
+    {
+        if (process_name.empty())
+        {
+            return NO_GROUP;
+        }
+
+        auto it = m_exact.find(process_name);
+        if (it != m_exact.end())
+        {
+            return it->second;
+        }
+
+        for (auto const &p : m_patterns)
+        {
+            bool const matched = p.is_regex
+                                     ? std::regex_match(process_name.begin(), process_name.end(), p.regex)
+                                     : glob_match(p.glob, process_name);
+            if (matched)
+            {
+                return p.group;
+            }
+        }
+        return NO_GROUP;
+    }
+
+} // namespace audio_mixer
@@ -0,0 +1,86 @@
+#include "frame_mailbox.hpp"
+
+namespace audio_mixer
+{
+    frame_mailbox_c::frame_mailbox_c()
+        : m_slots{},
+          m_write_index(0),
+          m_read_index(1),
+          m_middle(2),
+          m_published(0),
+          m_overwritten(0),
+          m_waiting(false)
+    {
+    }
+
+    // Publish a frame, replacing any unread one (producer thread only)
+    void frame_mailbox_c::publish(knob_frame const &frame)
+    {
+        m_slots[m_write_index] = frame;
+
+        // Hand the filled slot over and take back whichever slot was in the middle.
+        // Sequentially consistent so it orders against the m_waiting check below.
+        uint8_t previous = m_middle.exchange(static_cast<uint8_t>(m_write_index | FRESH_BIT));
+        m_write_index = previous & INDEX_MASK;
+
+        m_published.fetch_add(1, std::memory_order_relaxed);
+        if (previous & FRESH_BIT)
+        {
+            m_overwritten.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (m_waiting.load())
+        {
+            std::lock_guard<std::mutex> lock(m_wait_mutex);
+            m_wait_cv.notify_one();
+        }
+    }
+
+    // Take the newest unread frame, returns false if nothing new was published (consumer thread only)
+    bool frame_mailbox_c::take(knob_frame &frame)
+    {
+        if (!has_unread())
+        {
+            return false;
+        }
+
+        uint8_t previous = m_middle.exchange(m_read_index, std::memory_order_acq_rel);
+        m_read_index = previous & INDEX_MASK;
+        frame = m_slots[m_read_index];
+        return true;
+    }
+
+    // Check if an unread frame is waiting
+    bool frame_mailbox_c::has_unread() const
+    {
+        return (m_middle.load() & FRESH_BIT) != 0;
+    }
+
+    // Block until an unread frame is waiting or the timeout expires (consumer thread only)
+    bool frame_mailbox_c::wait_for_unread(std::chrono::milliseconds timeout)
+    {
+        if (has_unread())
+        {
+            return true;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wait_mutex);
+        m_waiting.store(true);
+        bool ready = m_wait_cv.wait_for(lock, timeout, [this]() { return has_unread(); });
+        m_waiting.store(false);
+        return ready;
+    }
+
+    // Total number of frames published
+    uint64_t frame_mailbox_c::published_count() const
+    {
+        return m_published.load(std::memory_order_relaxed);
+    }
+
+    // Number of frames replaced before the consumer read them
+    uint64_t frame_mailbox_c::overwritten_count() const
+    {
+        return m_overwritten.load(std::memory_order_relaxed);
+    }
+
+} // namespace audio_mixer
@@ -0,0 +1,66 @@
+#include "frame_parser.hpp"
+
+namespace audio_mixer
+{
+    namespace
+    {
+        // Accept any 1-4 digit number (0-1023 from Arduino)
+        constexpr uint8_t MAX_DIGITS = 4;
+        constexpr char SEPARATOR = '|';
+        constexpr uint8_t TEXT_FRAME_BITS = 10;
+    } // namespace
+
+    bool parse_frame(std::string_view line, uint16_t expected_count, knob_frame &frame)
+    {
+        uint16_t const limit = (expected_count == 0) ? AUDIO_MIXER_MAX_KNOBS : expected_count;
+        if (limit > AUDIO_MIXER_MAX_KNOBS)
+        {
+            return false;
+        }
+
+        uint16_t count = 0;
+        uint16_t value = 0;
+        uint8_t digits = 0;
+        for (char c : line)
+        {
+            if (c >= '0' && c <= '9')
+            {
+                if (++digits > MAX_DIGITS)
+                {
+                    return false;
+                }
+                value = static_cast<uint16_t>(value * 10 + (c - '0'));
+            }
+            else if (c == SEPARATOR)
+            {
+                // A separator must follow a number and leave room for at least one more value.
+                if (digits == 0 || count + 1 >= limit)
+                {
+                    return false;
+                }
+                frame.values[count++] = value;
+                value = 0;
+                digits = 0;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        if (digits == 0)
+        {
+            return false; // Empty line or trailing separator
+        }
+        frame.values[count++] = value;
+
+        if (expected_count != 0 && count != expected_count)
+        {
+            return false;
+        }
+        frame.count = count;
+        frame.bits = TEXT_FRAME_BITS;
+        return true;
+    }
+
+} // namespace audio_mixer
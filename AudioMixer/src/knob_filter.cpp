@@ -0,0 +1,201 @@
+#include "knob_filter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace audio_mixer
+{
+    namespace
+    {
+        // Cutoff of the One-Euro speed estimate
+        constexpr float SPEED_CUTOFF_HZ = 1.0f;
+        // Sample intervals outside this range are clamped, e.g. after a reconnect
+        constexpr float MIN_DT = 0.0001f;
+        constexpr float MAX_DT = 1.0f;
+        constexpr float TWO_PI = 6.28318530718f;
+        // Loops run over whole groups of knobs so they have no scalar tail,
+        // the arrays are sized for AUDIO_MIXER_MAX_KNOBS so the padding is there.
+        constexpr size_t KNOB_GROUP = 8;
+        // Output this close to the reading, in ADC units, rounds to it and the filter is settled
+        constexpr float SETTLE_TOLERANCE = 0.5f;
+
+        inline size_t padded(size_t count)
+        {
+            return std::min<size_t>((count + KNOB_GROUP - 1) & ~(KNOB_GROUP - 1), AUDIO_MIXER_MAX_KNOBS);
+        }
+
+        // Smoothing factor of a first order low-pass
+        inline float low_pass_alpha(float cutoff_hz, float dt)
+        {
+            float const r = TWO_PI * cutoff_hz * dt;
+            return r / (r + 1.0f);
+        }
+    } // namespace
+
+    knob_filter_c::knob_filter_c()
+        : m_history{},
+          m_value{},
+          m_speed{},
+          m_raw{}
+    {
+        configure(1, 0.0f, 0.0f);
+    }
+
+    void knob_filter_c::configure(size_t median, float min_cutoff_hz, float beta)
+    {
+        m_median = std::min<size_t>(std::max<size_t>(median, 1) | 1, AUDIO_MIXER_MAX_MEDIAN);
+        m_min_cutoff = std::max(min_cutoff_hz, 0.0f);
+        m_beta = std::max(beta, 0.0f);
+        reset();
+    }
+
+    void knob_filter_c::reset()
+    {
+        m_head = 0;
+        m_count = 0;
+        m_bits = 0;
+        m_last_ns = 0;
+        m_settled = true;
+    }
+
+    void knob_filter_c::apply(knob_frame const &frame, std::array<float, AUDIO_MIXER_MAX_KNOBS> &output)
+    {
+        size_t const count = std::min<size_t>(frame.count, AUDIO_MIXER_MAX_KNOBS);
+        uint64_t const now_ns = frame.received_ns != 0
+                                    ? frame.received_ns
+                                    : static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                                std::chrono::steady_clock::now().time_since_epoch())
+                                                                .count());
+
+        if (frame.count != m_count || frame.bits != m_bits)
+        {
+            // First frame or another controller, start from this reading
+            size_t const lanes = padded(count);
+            for (auto &slot : m_history)
+            {
+                std::copy_n(frame.values.begin(), lanes, slot.begin());
+            }
+            for (size_t k = 0; k < lanes; k++)
+            {
+                m_value[k] = frame.values[k];
+                m_speed[k] = 0.0f;
+                output[k] = m_value[k];
+            }
+            std::copy_n(frame.values.begin(), lanes, m_raw.begin());
+            m_head = 0;
+            m_count = frame.count;
+            m_bits = frame.bits;
+            m_last_ns = now_ns;
+            m_settled = true;
+            return;
+        }
+
+        std::copy_n(frame.values.begin(), padded(count), m_raw.begin());
+        step(now_ns, output);
+    }
+
+    void knob_filter_c::settle(uint64_t now_ns, std::array<float, AUDIO_MIXER_MAX_KNOBS> &output)
+    {
+        if (m_count == 0)
+        {
+            return;
+        }
+        step(now_ns, output);
+    }
+
+    void knob_filter_c::step(uint64_t now_ns, std::array<float, AUDIO_MIXER_MAX_KNOBS> &output)
+    {
+        size_t const count = std::min<size_t>(m_count, AUDIO_MIXER_MAX_KNOBS);
+        size_t const lanes = padded(count);
+        std::array<uint16_t, AUDIO_MIXER_MAX_KNOBS> filtered;
+        if (m_median > 1)
+        {
+            m_head = (m_head + 1) % m_median;
+            std::copy_n(m_raw.begin(), lanes, m_history[m_head].begin());
+            median(lanes, filtered);
+        }
+        else
+        {
+            std::copy_n(m_raw.begin(), lanes, filtered.begin());
+        }
+
+        for (size_t k = 0; k < lanes; k++)
+        {
+            output[k] = filtered[k];
+        }
+
+        if (m_min_cutoff > 0.0f)
+        {
+            float dt = static_cast<float>(now_ns - m_last_ns) * 1e-9f;
+            dt = std::min(std::max(dt, MIN_DT), MAX_DT);
+            one_euro(lanes, dt, static_cast<float>((1u << m_bits) - 1), output);
+        }
+        m_last_ns = now_ns;
+
+        // Done once every knob is within rounding of its reading, snap to it
+        // so the remaining tail of the low-pass is not stepped through
+        m_settled = true;
+        for (size_t k = 0; k < count; k++)
+        {
+            m_settled = m_settled && std::abs(output[k] - static_cast<float>(m_raw[k])) < SETTLE_TOLERANCE;
+        }
+        if (m_settled)
+        {
+            for (size_t k = 0; k < lanes; k++)
+            {
+                m_value[k] = m_raw[k];
+                m_speed[k] = 0.0f;
+                output[k] = m_raw[k];
+            }
+        }
+    }
+
+    void knob_filter_c::median(size_t count, std::array<uint16_t, AUDIO_MIXER_MAX_KNOBS> &output)
+    {
+        // Odd-even transposition sort of the window, every compare-exchange
+        // runs across all knobs at once.
+        std::array<std::array<uint16_t, AUDIO_MIXER_MAX_KNOBS>, AUDIO_MIXER_MAX_MEDIAN> window;
+        for (size_t slot = 0; slot < m_median; slot++)
+        {
+            std::copy_n(m_history[slot].begin(), count, window[slot].begin());
+        }
+        for (size_t pass = 0; pass < m_median; pass++)
+        {
+            for (size_t slot = pass & 1; slot + 1 < m_median; slot += 2)
+            {
+                auto &a = window[slot];
+                auto &b = window[slot + 1];
+                for (size_t k = 0; k < count; k++)
+                {
+                    uint16_t const lo = std::min(a[k], b[k]);
+                    uint16_t const hi = std::max(a[k], b[k]);
+                    a[k] = lo;
+                    b[k] = hi;
+                }
+            }
+        }
+        std::copy_n(window[m_median / 2].begin(), count, output.begin());
+    }
+
+    void knob_filter_c::one_euro(size_t count, float dt, float full_scale,
+                                 std::array<float, AUDIO_MIXER_MAX_KNOBS> &values)
+    {
+        float const speed_alpha = low_pass_alpha(SPEED_CUTOFF_HZ, dt);
+        float const speed_scale = 1.0f / (dt * full_scale); // ADC units per sample to full scale per second
+        float const r_min = TWO_PI * m_min_cutoff * dt;
+        float const r_beta = TWO_PI * m_beta * dt;
+
+        for (size_t k = 0; k < count; k++)
+        {
+            float const delta = values[k] - m_value[k];
+            float const speed = m_speed[k] + speed_alpha * (delta * speed_scale - m_speed[k]);
+            float const r = r_min + r_beta * std::abs(speed);
+            float const value = m_value[k] + delta * (r / (r + 1.0f));
+            m_speed[k] = speed;
+            m_value[k] = value;
+            values[k] = value;
+        }
+    }
+
+} // namespace audio_mixer
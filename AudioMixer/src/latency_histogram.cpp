@@ -0,0 +1,68 @@
+#include "latency_histogram.hpp"
+
+#include <cmath>
+
+namespace audio_mixer
+{
+    latency_histogram_c::latency_histogram_c()
+        : m_count(0),
+          m_max(0)
+    {
+        for (auto &bucket : m_counts)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t latency_histogram_c::count() const
+    {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+    uint64_t latency_histogram_c::max() const
+    {
+        return m_max.load(std::memory_order_relaxed);
+    }
+
+    uint64_t latency_histogram_c::value_at_percentile(double percentile) const
+    {
+        uint64_t const total = count();
+        if (total == 0)
+        {
+            return 0;
+        }
+
+        double const clamped = percentile < 0.0 ? 0.0 : (percentile > 100.0 ? 100.0 : percentile);
+        uint64_t target = static_cast<uint64_t>(std::ceil(clamped / 100.0 * static_cast<double>(total)));
+        if (target == 0)
+        {
+            target = 1;
+        }
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++)
+        {
+            seen += m_counts[i].load(std::memory_order_relaxed);
+            if (seen >= target)
+            {
+                // Never report more than was actually seen, the last bucket is open ended
+                uint64_t const bound = bucket_upper_bound(i);
+                uint64_t const largest = max();
+                return (bound < largest && i != BUCKETS - 1) ? bound : largest;
+            }
+        }
+        return max(); // Buckets and count read at slightly different moments
+    }
+
+    uint64_t latency_histogram_c::bucket_upper_bound(size_t index)
+    {
+        if (index < SUB_BUCKETS)
+        {
+            return index;
+        }
+        size_t const shift = index / SUB_BUCKETS - 1;
+        uint64_t const lower = static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+        return lower + ((uint64_t{1} << shift) - 1);
+    }
+
+} // namespace audio_mixer
@@ -0,0 +1,370 @@
+#include "logger.hpp"
+
+#include <cstring>
+
+namespace audio_mixer
+{
+    namespace
+    {
+        constexpr uintmax_t MAX_SIZE = 5 * 1024 * 1024; // 5 MB
+        // Longest a record waits in the ring before the writer picks it up.
+        constexpr std::chrono::milliseconds FLUSH_INTERVAL(20);
+        // Formatted bytes collected before they are handed to the file.
+        constexpr size_t BATCH_BYTES = 64 * 1024;
+
+        char const *level_tag(logger_c::LogLevel level)
+        {
+            switch (level)
+            {
+            case logger_c::DEBUG:
+                return "[DEBUG] ";
+            case logger_c::INFO:
+                return "[INFO] ";
+            case logger_c::WARNING:
+                return "[WARNING] ";
+            default:
+                return "[ERROR] ";
+            }
+        }
+    } // namespace
+
+    logger_c::logger_c()
+        : m_file_size(0),
+          m_time_second(0),
+          m_time_text{},
+          m_head(0),
+          m_tail(0),
+          m_dropped(0),
+          m_dropped_total(0),
+          m_async(false),
+          m_stop(false),
+          m_waiting(false)
+    {
+        // Determine log file path
+        std::string path = "audiomixer.log";
+#ifdef _WIN32
+        char exePath[MAX_PATH];
+        GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+        std::string exeDir(exePath);
+        auto pos = exeDir.find_last_of("\\/");
+        if (pos != std::string::npos)
+        {
+            exeDir = exeDir.substr(0, pos + 1);
+            path = exeDir + "audiomixer.log";
+        }
+#endif
+        logPath_ = path;
+        m_batch.reserve(BATCH_BYTES);
+        openLogFile();
+
+        // Set default log level
+        m_log_level = LogLevel::INFO; // Default to INFO level
+    }
+
+    logger_c::~logger_c()
+    {
+        set_async(false);
+        if (logfile_.is_open())
+            logfile_.close();
+    }
+
+    void logger_c::set_async(bool async)
+    {
+        if (async == m_writer.joinable())
+        {
+            return;
+        }
+
+        if (async)
+        {
+            if (!m_ring)
+            {
+                m_ring.reset(new record[RING_SIZE]);
+            }
+            for (size_t i = 0; i < RING_SIZE; i++)
+            {
+                m_ring[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            m_head.store(0);
+            m_tail = 0;
+            m_stop.store(false);
+            m_writer = std::thread([this]() { run_writer(); });
+            m_async.store(true);
+        }
+        else
+        {
+            m_async.store(false);
+            m_stop.store(true);
+            {
+                std::lock_guard<std::mutex> lock(m_wait_mutex);
+                m_wait_cv.notify_one();
+            }
+            m_writer.join();
+        }
+    }
+
+    void logger_c::set_file(std::string const &path)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (logfile_.is_open())
+            logfile_.close();
+        logPath_ = path;
+        openLogFile();
+    }
+
+    void logger_c::log(LogLevel level, std::string_view msg)
+    {
+        if (!enabled(level))
+        {
+            return;
+        }
+
+        // Stamped here so queued records keep the time they were logged at
+        auto const now = std::chrono::system_clock::now();
+        if (m_async.load(std::memory_order_relaxed))
+        {
+            push(level, now, msg);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        format(level, now, msg.data(), msg.size());
+        write_batch();
+        logfile_.flush();
+    }
+
+    // Bounded multi-producer queue: claim a position, fill the slot, then publish it
+    // through the slot's sequence number. The writer is the only consumer.
+    void logger_c::push(LogLevel level, std::chrono::system_clock::time_point time, std::string_view msg)
+    {
+        uint64_t position = m_head.load(std::memory_order_relaxed);
+        record *entry;
+        while (true)
+        {
+            entry = &m_ring[position & (RING_SIZE - 1)];
+            uint64_t const sequence = entry->sequence.load(std::memory_order_acquire);
+            int64_t const difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+            if (difference == 0)
+            {
+                if (m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                // Full, the writer is a whole ring behind
+                if (level < LogLevel::WARNING || !m_async.load(std::memory_order_relaxed))
+                {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    m_dropped_total.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(m_wait_mutex);
+                    m_wait_cv.notify_one();
+                }
+                std::this_thread::yield();
+                position = m_head.load(std::memory_order_relaxed);
+            }
+            else
+            {
+                position = m_head.load(std::memory_order_relaxed);
+            }
+        }
+
+        entry->level = level;
+        entry->time = time;
+        entry->length = msg.size();
+        if (msg.size() <= RECORD_TEXT)
+        {
+            std::memcpy(entry->text, msg.data(), msg.size());
+        }
+        else
+        {
+            entry->overflow.assign(msg.data(), msg.size());
+        }
+        entry->sequence.store(position + 1, std::memory_order_release);
+
+        // Routine records are collected for a batch; wake the writer early for
+        // problems and before the ring fills up
+        bool const urgent = level >= LogLevel::WARNING || (position & (RING_SIZE / 2 - 1)) == 0;
+        if (urgent && m_waiting.load())
+        {
+            std::lock_guard<std::mutex> lock(m_wait_mutex);
+            m_wait_cv.notify_one();
+        }
+    }
+
+    void logger_c::run_writer()
+    {
+        while (true)
+        {
+            bool const stopping = m_stop.load();
+            drain();
+            if (stopping)
+            {
+                break;
+            }
+
+            std::unique_lock<std::mutex> lock(m_wait_mutex);
+            m_waiting.store(true);
+            m_wait_cv.wait_for(lock, FLUSH_INTERVAL);
+            m_waiting.store(false);
+        }
+    }
+
+    // Format everything queued and write it with one flush
+    void logger_c::drain()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (true)
+        {
+            record &entry = m_ring[m_tail & (RING_SIZE - 1)];
+            if (entry.sequence.load(std::memory_order_acquire) != m_tail + 1)
+            {
+                break;
+            }
+            format(entry.level, entry.time, entry.length <= RECORD_TEXT ? entry.text : entry.overflow.data(),
+                   entry.length);
+            entry.sequence.store(m_tail + RING_SIZE, std::memory_order_release);
+            m_tail++;
+
+            if (m_batch.size() >= BATCH_BYTES)
+            {
+                write_batch();
+            }
+        }
+
+        uint64_t const dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped != 0)
+        {
+            std::string const msg = std::to_string(dropped) + " log messages dropped, the log writer fell behind";
+            format(LogLevel::WARNING, std::chrono::system_clock::now(), msg.data(), msg.size());
+        }
+
+        if (!m_batch.empty())
+        {
+            write_batch();
+            logfile_.flush();
+        }
+    }
+
+    // Append one line to m_batch, the date is only formatted once per second
+    void logger_c::format(LogLevel level, std::chrono::system_clock::time_point time, char const *text, size_t length)
+    {
+        std::time_t const now_c = std::chrono::system_clock::to_time_t(time);
+        if (now_c != m_time_second)
+        {
+            std::tm tm_buf;
+#ifdef _WIN32
+            localtime_s(&tm_buf, &now_c);
+#else
+            localtime_r(&now_c, &tm_buf);
+#endif
+            std::strftime(m_time_text, sizeof(m_time_text), "%Y-%m-%d %H:%M:%S", &tm_buf);
+            m_time_second = now_c;
+        }
+
+        m_batch += '[';
+        m_batch += m_time_text;
+        m_batch += "] ";
+        m_batch += level_tag(level);
+        m_batch.append(text, length);
+        m_batch += '\n';
+    }
+
+    void logger_c::write_batch()
+    {
+        checkRolling(m_batch.size());
+        logfile_.write(m_batch.data(), static_cast<std::streamsize>(m_batch.size()));
+        m_file_size += m_batch.size();
+        m_batch.clear();
+    }
+
+    // Roll the file once it reached MAX_SIZE, the size is tracked in memory.
+    void logger_c::checkRolling(size_t incoming)
+    {
+        if (m_file_size < MAX_SIZE || incoming == 0)
+        {
+            return;
+        }
+
+        // Close current file
+        logfile_.close();
+
+        // Create a timestamp suffix for the backup filename
+        auto t = std::time(nullptr);
+        std::tm tm_snapshot;
+#ifdef _WIN32
+        localtime_s(&tm_snapshot, &t);
+#else
+        localtime_r(&t, &tm_snapshot);
+#endif
+        std::ostringstream oss;
+        oss << std::put_time(&tm_snapshot, "%Y%m%d_%H%M%S");
+        std::string backupName = logPath_ + "." + oss.str();
+
+        // Rename the current log file
+        std::error_code ec;
+        std::filesystem::rename(logPath_, backupName, ec);
+
+        // Clean up old rolled logs if too many exist.
+        cleanupOldLogs();
+
+        // Reopen a new log file
+        openLogFile();
+    }
+
+    // Delete the oldest log files if we have more than m_max_log_files.
+    void logger_c::cleanupOldLogs()
+    {
+        namespace fs = std::filesystem;
+        fs::path logFilePath(logPath_);
+        fs::path logDir = logFilePath.has_parent_path() ? logFilePath.parent_path() : fs::path(".");
+        std::string baseName = logFilePath.filename().string(); // e.g. "audiomixer.log"
+        std::vector<fs::directory_entry> rolledFiles;
+
+        // Iterate over directory contents and filter those matching the backup pattern.
+        for (const auto &entry : fs::directory_iterator(logDir))
+        {
+            if (entry.is_regular_file())
+            {
+                std::string fname = entry.path().filename().string();
+                // Check if the filename starts with the base name plus a dot.
+                if (fname.rfind(baseName + ".", 0) == 0)
+                {
+                    rolledFiles.push_back(entry);
+                }
+            }
+        }
+
+        // If there are too many, sort by last write time and remove the oldest.
+        if (rolledFiles.size() > m_max_log_files)
+        {
+            std::sort(rolledFiles.begin(), rolledFiles.end(), [](const fs::directory_entry &a, const fs::directory_entry &b)
+            {
+                return fs::last_write_time(a.path()) < fs::last_write_time(b.path());
+            });
+            std::size_t numToDelete = rolledFiles.size() - m_max_log_files;
+            for (std::size_t i = 0; i < numToDelete; ++i)
+            {
+                fs::remove(rolledFiles[i].path());
+            }
+        }
+    }
+
+    void logger_c::openLogFile()
+    {
+        logfile_.open(logPath_, std::ios::app);
+
+        // The only size query, later writes are counted
+        std::error_code ec;
+        m_file_size = std::filesystem::file_size(logPath_, ec);
+        if (ec)
+        {
+            m_file_size = 0;
+        }
+    }
+
+} // namespace audio_mixer
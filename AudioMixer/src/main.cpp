@@ -8,6 +8,7 @@
 
 #ifdef _WIN32
 #include <windows.h>
+#include <timeapi.h>
 #endif
 
 // Global exit flag
@@ -36,28 +37,29 @@ int main()
     SetConsoleCtrlHandler(HandlerRoutine, TRUE);
     SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
     SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS);
+    // 1 ms timer resolution, otherwise ramp ticks and timed waits round up to 15.6 ms
+    timeBeginPeriod(1);
 #endif
 
     // Initialize logging
     // TODO: Make this configurable using command line arguments or config file
     audio_mixer::logger_c::instance().set_log_level(audio_mixer::logger_c::LogLevel::DEBUG);
+    // Format and write on a background thread, the serial and mixer threads log per frame
+    audio_mixer::logger_c::instance().set_async(true);
     audio_mixer::log_info("AudioMixer starting");
-    audio_mixer::log_debug("AudioMixer build version: " + std::to_string(AudioMixer_VERSION_MAJOR) + "." +
-                     std::to_string(AudioMixer_VERSION_MINOR));
-    audio_mixer::log_debug("Build date: " __DATE__ " " __TIME__);
-    audio_mixer::log_debug("Platform: " + std::string(
+    AUDIO_MIXER_LOG_DEBUG("AudioMixer build version: ", AudioMixer_VERSION_MAJOR, ".", AudioMixer_VERSION_MINOR);
+    AUDIO_MIXER_LOG_DEBUG("Build date: " __DATE__ " " __TIME__);
 #ifdef _WIN32
-        "Windows"
+    AUDIO_MIXER_LOG_DEBUG("Platform: Windows");
 #else
-        "Linux"
+    AUDIO_MIXER_LOG_DEBUG("Platform: Linux");
 #endif
-    ));
 
     try
     {
         boost::asio::io_context io_context;
         audio_mixer::audio_mixer_c app(io_context);
-        audio_mixer::serial_connection_c connection(io_context, app.get_data_stack(), app.get_baud_rate());
+        audio_mixer::serial_connection_c connection(io_context, app.get_frame_mailbox(), app.get_baud_rate());
 
         // Run Serial interface in a separate thread
         auto serial_run = [&connection]()
@@ -94,6 +96,10 @@ int main()
     }
 
     audio_mixer::log_info("AudioMixer exiting");
+    audio_mixer::logger_c::instance().set_async(false);
+#ifdef _WIN32
+    timeEndPeriod(1);
+#endif
 
     return 0;
 }
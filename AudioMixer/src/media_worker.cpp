@@ -0,0 +1,264 @@
+#include "media_worker.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <objbase.h>
+#endif
+
+#include "metrics.hpp"
+#include "pipeline_latency.hpp"
+#include "trace.hpp"
+
+namespace audio_mixer
+{
+    namespace
+    {
+        uint32_t to_bits(float value)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+
+        float from_bits(uint32_t bits)
+        {
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        uint64_t count_bits(uint64_t mask)
+        {
+            uint64_t count = 0;
+            for (; mask != 0; mask &= mask - 1)
+            {
+                ++count;
+            }
+            return count;
+        }
+    } // namespace
+
+    media_worker_c::media_worker_c(std::unique_ptr<os_media_interface_c> media)
+        : m_media(std::move(media)),
+          m_pending(0),
+          m_failed(0),
+          m_batches(0),
+          m_replaced(0),
+          m_config_changed(false),
+          m_stop(false),
+          m_waiting(false)
+    {
+        for (size_t i = 0; i < AUDIO_MIXER_MAX_KNOBS; i++)
+        {
+            m_volumes[i].store(0, std::memory_order_relaxed);
+            m_received_ns[i].store(0, std::memory_order_relaxed);
+        }
+        m_thread = std::thread([this]() { run(); });
+    }
+
+    media_worker_c::~media_worker_c()
+    {
+        m_stop.store(true);
+        {
+            std::lock_guard<std::mutex> lock(m_wait_mutex);
+            m_wait_cv.notify_one();
+        }
+        m_thread.join();
+    }
+
+    void media_worker_c::configure(std::vector<endpoint> endpoints, std::shared_ptr<endpoint_matcher_c const> matcher)
+    {
+        // Dropped before the new config is published, so the worker cannot take the
+        // config and still find old commands. Only submit() sets bits and it runs on
+        // this thread, so anything queued after this belongs to the new config.
+        m_pending.store(0);
+        {
+            std::lock_guard<std::mutex> lock(m_config_mutex);
+            m_next_config.reset(new configuration{std::move(endpoints), std::move(matcher)});
+        }
+        m_config_changed.store(true);
+        if (m_waiting.load())
+        {
+            std::lock_guard<std::mutex> lock(m_wait_mutex);
+            m_wait_cv.notify_one();
+        }
+    }
+
+    void media_worker_c::submit(uint64_t mask, std::array<float, AUDIO_MIXER_MAX_KNOBS> const &volumes,
+                                uint64_t received_ns)
+    {
+        if (mask == 0)
+        {
+            return;
+        }
+        for (size_t index = 0; index < AUDIO_MIXER_MAX_KNOBS; index++)
+        {
+            if (mask & (uint64_t{1} << index))
+            {
+                m_volumes[index].store(to_bits(volumes[index]), std::memory_order_relaxed);
+                m_received_ns[index].store(received_ns, std::memory_order_relaxed);
+            }
+        }
+
+        // One fetch_or for all slots, so a worker waking in between never sees half a frame.
+        // Sequentially consistent so the slots are visible to whoever swaps the bits
+        // out, and so it orders against the m_waiting check below.
+        uint64_t const replaced = m_pending.fetch_or(mask) & mask;
+        if (replaced != 0)
+        {
+            m_replaced.fetch_add(count_bits(replaced), std::memory_order_relaxed);
+        }
+
+        if (m_waiting.load())
+        {
+            std::lock_guard<std::mutex> lock(m_wait_mutex);
+            m_wait_cv.notify_one();
+        }
+    }
+
+    uint64_t media_worker_c::take_failed()
+    {
+        // Failures the backend only heard of after its batch returned
+        uint64_t const late = m_media->take_failed();
+        if (late != 0)
+        {
+            metrics_c::instance().add(Counter::BACKEND_FAILURES, count_bits(late));
+        }
+        if (m_failed.load(std::memory_order_relaxed) == 0)
+        {
+            return late;
+        }
+        return m_failed.exchange(0, std::memory_order_acq_rel) | late;
+    }
+
+    bool media_worker_c::has_work() const
+    {
+        return m_pending.load() != 0 || m_config_changed.load() || m_stop.load();
+    }
+
+    void media_worker_c::run()
+    {
+#ifdef _WIN32
+        // The backend was created on another thread, join the same multithreaded apartment
+        CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+#endif
+        while (true)
+        {
+            if (!has_work())
+            {
+                std::unique_lock<std::mutex> lock(m_wait_mutex);
+                m_waiting.store(true);
+                m_wait_cv.wait(lock, [this]() { return has_work(); });
+                m_waiting.store(false);
+            }
+            if (m_stop.load())
+            {
+                break;
+            }
+
+            if (m_config_changed.exchange(false))
+            {
+                std::lock_guard<std::mutex> lock(m_config_mutex);
+                m_config = std::move(m_next_config);
+                m_media->set_matcher(m_config->matcher);
+                // Failures of batches made with the old config, their indexes mean other endpoints now
+                m_failed.store(0, std::memory_order_relaxed);
+            }
+
+            uint64_t const pending = m_pending.exchange(0);
+            if (pending != 0)
+            {
+                apply(pending);
+            }
+        }
+#ifdef _WIN32
+        CoUninitialize();
+#endif
+    }
+
+    void media_worker_c::apply(uint64_t pending)
+    {
+        if (!m_config)
+        {
+            return;
+        }
+
+        // One batch, so the backend walks its sessions once for all endpoints
+        std::vector<volume_change> changes;
+        std::array<uint8_t, AUDIO_MIXER_MAX_KNOBS> indexes;
+        std::array<uint64_t, AUDIO_MIXER_MAX_KNOBS> received;
+        size_t const count = std::min<size_t>(m_config->endpoints.size(), AUDIO_MIXER_MAX_KNOBS);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (pending & (uint64_t{1} << i))
+            {
+                indexes[changes.size()] = static_cast<uint8_t>(i);
+                received[changes.size()] = m_received_ns[i].load(std::memory_order_relaxed);
+                changes.push_back(volume_change{&m_config->endpoints[i], i,
+                                                from_bits(m_volumes[i].load(std::memory_order_relaxed))});
+            }
+        }
+        if (changes.empty())
+        {
+            return;
+        }
+
+        uint64_t const call_start = pipeline_latency_c::now_ns();
+        std::vector<ApplyResult> results = m_media->set_volumes(changes);
+        uint64_t const call_end = pipeline_latency_c::now_ns();
+        m_batches.fetch_add(1, std::memory_order_relaxed);
+
+        auto &latency = pipeline_latency_c::instance();
+        auto &trace = trace_c::instance();
+        uint64_t failed = 0;
+        uint64_t not_found_count = 0;
+        uint64_t failed_count = 0;
+        uint64_t newest_ns = 0;
+        for (size_t n = 0; n < changes.size(); n++)
+        {
+            size_t const i = indexes[n];
+            ApplyResult const result = n < results.size() ? results[n] : ApplyResult::FAILED;
+            trace.apply(i, static_cast<uint8_t>(result), call_end, call_end - call_start);
+            if (result != ApplyResult::APPLIED)
+            {
+                // Not running or failed, the mixer sends the next target again
+                failed |= uint64_t{1} << i;
+            }
+            if (result == ApplyResult::FAILED)
+            {
+                failed_count++;
+            }
+            if (result == ApplyResult::NOT_FOUND)
+            {
+                not_found_count++;
+                continue;
+            }
+            // Each endpoint waits for the whole batch
+            latency.record_endpoint(i, call_end - call_start);
+            newest_ns = std::max(newest_ns, received[n]);
+        }
+        if (newest_ns != 0)
+        {
+            latency.record(Stage::TOTAL, call_end - newest_ns);
+        }
+
+        // One update per batch rather than per endpoint
+        auto &metrics = metrics_c::instance();
+        metrics.add(Counter::BACKEND_CALLS, changes.size());
+        if (not_found_count != 0)
+        {
+            metrics.add(Counter::BACKEND_NOT_FOUND, not_found_count);
+        }
+        if (failed_count != 0)
+        {
+            metrics.add(Counter::BACKEND_FAILURES, failed_count);
+        }
+        if (failed != 0)
+        {
+            m_failed.fetch_or(failed, std::memory_order_release);
+        }
+    }
+
+} // namespace audio_mixer
@@ -0,0 +1,154 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <iterator>
+
+#include "pipeline_latency.hpp"
+
+namespace audio_mixer
+{
+    namespace
+    {
+        struct metric_info
+        {
+            char const *name;
+            char const *help;
+        };
+
+        constexpr metric_info COUNTER_INFO[] = {
+            {"audiomixer_serial_records_received_total", "Lines or packets read from the controller"},
+            {"audiomixer_frames_parsed_total", "Frames decoded and published to the mixer"},
+            {"audiomixer_frames_discarded_total", "Malformed lines and corrupt packets"},
+            {"audiomixer_frames_lost_total", "Packets missing from the binary protocol sequence"},
+            {"audiomixer_frame_size_mismatches_total", "Frames whose knob count does not match num_of_knobs"},
+            {"audiomixer_heartbeats_total", "Heartbeats received from the controller"},
+            {"audiomixer_serial_reconnects_total", "Serial sessions started after the first one"},
+            {"audiomixer_backend_calls_total", "Volumes handed to the media backend"},
+            {"audiomixer_backend_not_found_total", "Volumes for applications that were not playing audio"},
+            {"audiomixer_backend_failures_total", "Volumes the media backend failed to set"},
+            {"audiomixer_config_reloads_total", "config.yaml changes applied without a restart"},
+        };
+        static_assert(std::size(COUNTER_INFO) == static_cast<size_t>(Counter::COUNT), "a name per counter");
+
+        constexpr metric_info GAUGE_INFO[] = {
+            {"audiomixer_serial_connected", "1 while a serial session is running"},
+            {"audiomixer_endpoints", "Endpoints in the config in use"},
+        };
+        static_assert(std::size(GAUGE_INFO) == static_cast<size_t>(Gauge::COUNT), "a name per gauge");
+
+        // Reported latency quantiles, as fractions and as latency_histogram_c percentiles
+        constexpr std::pair<char const *, double> QUANTILES[] = {{"0.5", 50.0}, {"0.99", 99.0}, {"0.999", 99.9}};
+
+        // The frame rate is not re-measured over windows shorter than this
+        constexpr auto MIN_RATE_WINDOW = std::chrono::seconds(1);
+
+        void append_header(std::string &out, char const *name, char const *help, char const *type)
+        {
+            out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+            out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+        }
+
+        void append_value(std::string &out, char const *name, char const *labels, double value)
+        {
+            char line[192];
+            std::snprintf(line, sizeof(line), "%s%s %.9g\n", name, labels, value);
+            out += line;
+        }
+
+        void append_value(std::string &out, char const *name, uint64_t value)
+        {
+            char line[192];
+            std::snprintf(line, sizeof(line), "%s %" PRIu64 "\n", name, value);
+            out += line;
+        }
+
+        // Latency quantiles in seconds, plus the sample count
+        void append_summary(std::string &out, char const *name, std::string const &labels,
+                            latency_histogram_c const &histogram)
+        {
+            char label_text[96];
+            for (auto const &quantile : QUANTILES)
+            {
+                std::snprintf(label_text, sizeof(label_text), "{%s%squantile=\"%s\"}", labels.c_str(),
+                              labels.empty() ? "" : ",", quantile.first);
+                append_value(out, name, label_text,
+                             static_cast<double>(histogram.value_at_percentile(quantile.second)) / 1e9);
+            }
+            std::snprintf(label_text, sizeof(label_text), "%s%s%s", labels.empty() ? "" : "{", labels.c_str(),
+                          labels.empty() ? "" : "}");
+            append_value(out, (std::string(name) + "_count").c_str(), label_text,
+                         static_cast<double>(histogram.count()));
+        }
+    } // namespace
+
+    void metrics_c::add_source(std::string const &name, std::string const &help, std::function<uint64_t()> read)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto existing = std::find_if(m_sources.begin(), m_sources.end(),
+                                     [&](source const &candidate) { return candidate.name == name; });
+        if (existing != m_sources.end())
+        {
+            existing->help = help;
+            existing->read = std::move(read);
+            return;
+        }
+        m_sources.push_back({name, help, std::move(read)});
+    }
+
+    std::string metrics_c::render()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::string out;
+        out.reserve(4096);
+
+        for (size_t i = 0; i < m_counters.size(); i++)
+        {
+            append_header(out, COUNTER_INFO[i].name, COUNTER_INFO[i].help, "counter");
+            append_value(out, COUNTER_INFO[i].name, m_counters[i].value.load(std::memory_order_relaxed));
+        }
+        for (auto const &entry : m_sources)
+        {
+            append_header(out, entry.name.c_str(), entry.help.c_str(), "counter");
+            append_value(out, entry.name.c_str(), entry.read());
+        }
+        for (size_t i = 0; i < m_gauges.size(); i++)
+        {
+            append_header(out, GAUGE_INFO[i].name, GAUGE_INFO[i].help, "gauge");
+            append_value(out, GAUGE_INFO[i].name, "",
+                         static_cast<double>(static_cast<int64_t>(m_gauges[i].value.load(std::memory_order_relaxed))));
+        }
+
+        // Frames per second since the previous export
+        auto const now = std::chrono::steady_clock::now();
+        uint64_t const frames = get(Counter::FRAMES_PARSED);
+        if (now - m_rate_time >= MIN_RATE_WINDOW)
+        {
+            m_frame_rate = static_cast<double>(frames - m_rate_frames) /
+                           std::chrono::duration<double>(now - m_rate_time).count();
+            m_rate_frames = frames;
+            m_rate_time = now;
+        }
+        append_header(out, "audiomixer_frame_rate_hz", "Frames parsed per second since the previous export", "gauge");
+        append_value(out, "audiomixer_frame_rate_hz", "", m_frame_rate);
+
+        auto const &latency = pipeline_latency_c::instance();
+        append_header(out, "audiomixer_apply_latency_seconds",
+                      "Time from reading a frame until the backend applied its volumes", "summary");
+        append_summary(out, "audiomixer_apply_latency_seconds", "", latency.stage(Stage::TOTAL));
+
+        append_header(out, "audiomixer_backend_call_seconds", "Duration of the backend call per knob", "summary");
+        for (size_t i = 0; i < AUDIO_MIXER_MAX_KNOBS; i++)
+        {
+            auto const &histogram = latency.endpoint_histogram(i);
+            if (histogram.count() != 0)
+            {
+                append_summary(out, "audiomixer_backend_call_seconds", "knob=\"" + std::to_string(i) + "\"",
+                               histogram);
+            }
+        }
+        return out;
+    }
+
+} // namespace audio_mixer
@@ -0,0 +1,147 @@
+#include "metrics_exporter.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+#include "logger.hpp"
+#include "metrics.hpp"
+
+namespace audio_mixer
+{
+    metrics_exporter_c::metrics_exporter_c(boost::asio::io_context &context)
+        :
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+          m_acceptor(context),
+#endif
+          m_interval(0),
+          m_timer(context)
+    {
+    }
+
+    metrics_exporter_c::~metrics_exporter_c()
+    {
+        stop();
+    }
+
+    bool metrics_exporter_c::listen(std::string const &path)
+    {
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+        // A socket file left behind by a previous run would make bind fail
+        std::error_code error;
+        std::filesystem::remove(path, error);
+
+        boost::system::error_code ec;
+        boost::asio::local::stream_protocol::endpoint const endpoint(path);
+        m_acceptor.open(endpoint.protocol(), ec);
+        if (!ec)
+        {
+            m_acceptor.bind(endpoint, ec);
+        }
+        if (!ec)
+        {
+            m_acceptor.listen(boost::asio::socket_base::max_listen_connections, ec);
+        }
+        if (ec)
+        {
+            audio_mixer::log_error("Cannot serve metrics on " + path + ": " + ec.message());
+            boost::system::error_code ignored;
+            m_acceptor.close(ignored);
+            return false;
+        }
+        m_socket_path = path;
+        start_accept();
+        audio_mixer::log_info("Serving metrics on " + path);
+        return true;
+#else
+        audio_mixer::log_warning("Unix domain sockets are not supported, not serving metrics on " + path);
+        return false;
+#endif
+    }
+
+    void metrics_exporter_c::write_textfile(std::string const &path, std::chrono::seconds interval)
+    {
+        m_textfile_path = path;
+        m_interval = std::max(interval, std::chrono::seconds(1));
+        write_file();
+        schedule_write();
+    }
+
+    void metrics_exporter_c::stop()
+    {
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+        if (m_acceptor.is_open())
+        {
+            boost::system::error_code ec;
+            m_acceptor.close(ec);
+            std::error_code error;
+            std::filesystem::remove(m_socket_path, error);
+        }
+#endif
+        m_timer.cancel();
+    }
+
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+    void metrics_exporter_c::start_accept()
+    {
+        m_acceptor.async_accept(
+            [this](boost::system::error_code const &ec, boost::asio::local::stream_protocol::socket socket)
+            {
+                if (ec)
+                {
+                    if (ec != boost::asio::error::operation_aborted)
+                    {
+                        audio_mixer::log_error("metrics_exporter_c: accept error: " + ec.message());
+                    }
+                    return;
+                }
+
+                // The connection and its text live until the write completed
+                auto client = std::make_shared<boost::asio::local::stream_protocol::socket>(std::move(socket));
+                auto text = std::make_shared<std::string>(metrics_c::instance().render());
+                boost::asio::async_write(*client, boost::asio::buffer(*text),
+                                         [client, text](boost::system::error_code const &, std::size_t) {
+                                             boost::system::error_code ignored;
+                                             client->shutdown(boost::asio::socket_base::shutdown_both, ignored);
+                                         });
+                start_accept();
+            });
+    }
+#endif
+
+    void metrics_exporter_c::write_file()
+    {
+        std::string const temp_path = m_textfile_path + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            file << metrics_c::instance().render();
+            if (!file)
+            {
+                audio_mixer::log_error("Cannot write metrics to " + temp_path);
+                return;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temp_path, m_textfile_path, error);
+        if (error)
+        {
+            audio_mixer::log_error("Cannot replace " + m_textfile_path + ": " + error.message());
+        }
+    }
+
+    void metrics_exporter_c::schedule_write()
+    {
+        m_timer.expires_after(m_interval);
+        m_timer.async_wait(
+            [this](boost::system::error_code const &ec) {
+                if (ec)
+                {
+                    return;
+                }
+                write_file();
+                schedule_write();
+            });
+    }
+
+} // namespace audio_mixer
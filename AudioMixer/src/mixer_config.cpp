@@ -0,0 +1,187 @@
+#include "mixer_config.hpp"
+
+#include <string_view>
+#include <unordered_map>
+#include <yaml-cpp/yaml.h>
+
+#include "logger.hpp"
+
+namespace audio_mixer
+{
+    namespace
+    {
+        // Endpoint for a list of applications, named after them unless a name is given
+        endpoint make_group(YAML::Node const &applications, std::string name)
+        {
+            auto entries = applications.as<std::vector<std::string>>();
+            if (name.empty())
+            {
+                for (auto const &entry : entries)
+                {
+                    name += (name.empty() ? "" : ", ") + entry;
+                }
+            }
+            endpoint group(name);
+            group.applications = std::move(entries);
+            return group;
+        }
+
+        // Taper from optional config values, warns about unknown names and unusable points
+        taper_c read_taper(YAML::Node const &node, YAML::Node const &points, taper_c const &fallback)
+        {
+            if (!node)
+            {
+                return fallback;
+            }
+            Taper curve = Taper::LINEAR;
+            if (!parse_taper(node.as<std::string>(), curve))
+            {
+                audio_mixer::log_warning("Unknown taper \"" + node.as<std::string>() + "\", using default");
+                return fallback;
+            }
+
+            taper_c taper;
+            if (curve != Taper::CUSTOM)
+            {
+                taper.set_curve(curve);
+            }
+            else if (!points || !taper.set_custom(points.as<std::vector<float>>()))
+            {
+                audio_mixer::log_warning("A custom taper needs taper_points with at least two volumes, using default");
+                return fallback;
+            }
+            return taper;
+        }
+
+        // Ramp mode from an optional config value, warns about unknown names
+        RampMode read_ramp_mode(YAML::Node const &node, RampMode fallback)
+        {
+            if (!node)
+            {
+                return fallback;
+            }
+            RampMode mode = fallback;
+            if (!parse_ramp_mode(node.as<std::string>(), mode))
+            {
+                audio_mixer::log_warning("Unknown ramp \"" + node.as<std::string>() + "\", using default");
+            }
+            return mode;
+        }
+
+        // Warn about endpoints assigned to more than one knob
+        void check_duplicates(std::vector<endpoint> const &endpoints)
+        {
+            std::unordered_map<std::string_view, size_t, case_fold_hash, case_fold_equal> slots;
+            for (size_t i = 0; i < endpoints.size(); i++)
+            {
+                if (!slots.emplace(endpoints[i].key, i).second)
+                {
+                    audio_mixer::log_warning("Endpoint \"" + endpoints[i].name +
+                                             "\" is assigned to more than one knob, they will override each other");
+                }
+            }
+        }
+    } // namespace
+
+    std::shared_ptr<mixer_config const> load_mixer_config(std::string const &path)
+    {
+        YAML::Node config = YAML::LoadFile(path);
+        auto snapshot = std::make_shared<mixer_config>();
+
+        snapshot->num_of_knobs = config["num_of_knobs"].as<uint16_t>(5);
+        snapshot->baud_rate = config["baud_rate"].as<uint32_t>(9600);
+        snapshot->data_rate_ms = config["data_rate_ms"].as<uint16_t>(50);
+        snapshot->min_update_interval = std::chrono::milliseconds(config["min_update_interval_ms"].as<uint16_t>(0));
+        snapshot->volume_step = config["volume_step"].as<float>(0.0f);
+        snapshot->dead_band = config["dead_band"].as<float>(0.0f);
+        snapshot->endpoint_min_interval = std::chrono::milliseconds(config["endpoint_min_interval_ms"].as<uint16_t>(0));
+        snapshot->filter_median = config["filter_median"].as<uint16_t>(1);
+        snapshot->filter_min_cutoff_hz = config["filter_min_cutoff_hz"].as<float>(0.0f);
+        snapshot->filter_beta = config["filter_beta"].as<float>(0.0f);
+        snapshot->ramp_tick = std::chrono::milliseconds(config["ramp_tick_ms"].as<uint16_t>(10));
+        snapshot->trace_file = config["trace_file"].as<std::string>("");
+        snapshot->trace_records = config["trace_records"].as<uint32_t>(65536);
+        snapshot->metrics_socket = config["metrics_socket"].as<std::string>("");
+        snapshot->metrics_textfile = config["metrics_textfile"].as<std::string>("");
+        snapshot->metrics_interval = std::chrono::seconds(config["metrics_interval_s"].as<uint16_t>(15));
+
+        if (snapshot->num_of_knobs == 0 || snapshot->num_of_knobs > AUDIO_MIXER_MAX_KNOBS)
+        {
+            audio_mixer::log_error("num_of_knobs must be between 1 and " + std::to_string(AUDIO_MIXER_MAX_KNOBS));
+            snapshot->num_of_knobs = 5;
+        }
+
+        // Endpoints inherit these unless they set their own
+        RampMode default_ramp = read_ramp_mode(config["ramp"], RampMode::NONE);
+        uint16_t default_ramp_ms = config["ramp_ms"].as<uint16_t>(0);
+        taper_c const default_taper = read_taper(config["taper"], config["taper_points"], taper_c());
+        snapshot->tapers.fill(default_taper);
+
+        std::string update_mode = toLower(config["update_mode"].as<std::string>("event"));
+        if (update_mode == "poll")
+        {
+            snapshot->update_mode = UpdateMode::POLL;
+        }
+        else if (update_mode == "event")
+        {
+            snapshot->update_mode = UpdateMode::EVENT;
+        }
+        else
+        {
+            audio_mixer::log_warning("Unknown update_mode \"" + update_mode + "\", using event");
+            snapshot->update_mode = UpdateMode::EVENT;
+        }
+
+        auto &endpoints = snapshot->endpoints;
+        if (config["endpoints"])
+        {
+            for (const auto &ep : config["endpoints"])
+            {
+                // A plain name, a list of names, globs and /regexes/, or a map with
+                // per endpoint settings and optionally such a list as "apps"
+                RampMode ramp = default_ramp;
+                uint16_t ramp_ms = default_ramp_ms;
+                if (ep.IsMap())
+                {
+                    endpoints.emplace_back(ep["apps"] ? make_group(ep["apps"], ep["name"].as<std::string>(""))
+                                                      : endpoint(ep["name"].as<std::string>()));
+                    ramp = read_ramp_mode(ep["ramp"], default_ramp);
+                    ramp_ms = ep["ramp_ms"].as<uint16_t>(default_ramp_ms);
+                    if (endpoints.size() <= AUDIO_MIXER_MAX_KNOBS)
+                    {
+                        snapshot->tapers[endpoints.size() - 1] = read_taper(
+                            ep["taper"], ep["taper_points"] ? ep["taper_points"] : config["taper_points"],
+                            default_taper);
+                    }
+                }
+                else if (ep.IsSequence())
+                {
+                    endpoints.emplace_back(make_group(ep, ""));
+                }
+                else
+                {
+                    endpoints.emplace_back(endpoint(ep.as<std::string>()));
+                }
+                if (endpoints.size() <= AUDIO_MIXER_MAX_KNOBS)
+                {
+                    snapshot->ramp_modes[endpoints.size() - 1] = ramp;
+                    snapshot->ramp_times[endpoints.size() - 1] = std::chrono::milliseconds(ramp_ms);
+                }
+            }
+        }
+        check_duplicates(endpoints);
+
+        // Patterns are compiled here once, backends match each new session against them
+        snapshot->matcher = std::make_shared<endpoint_matcher_c const>(endpoints);
+        return snapshot;
+    }
+
+    std::shared_ptr<mixer_config const> default_mixer_config()
+    {
+        auto snapshot = std::make_shared<mixer_config>();
+        snapshot->endpoints.emplace_back(endpoint("master"));
+        snapshot->matcher = std::make_shared<endpoint_matcher_c const>(snapshot->endpoints);
+        return snapshot;
+    }
+
+} // namespace audio_mixer
@@ -0,0 +1,74 @@
+#include "os_media_interface.hpp"
+
+#ifdef _WIN32
+#include "windows_media_interface.hpp"
+#elif defined(AUDIO_MIXER_HAVE_PULSE)
+#include "pulse_media_interface.hpp"
+#endif
+
+namespace audio_mixer
+{
+    void os_media_interface_c::set_matcher(std::shared_ptr<endpoint_matcher_c const> matcher)
+    {
+        m_matcher = std::move(matcher);
+    }
+
+    std::vector<ApplyResult> os_media_interface_c::set_volumes(std::vector<volume_change> const &changes)
+    {
+        std::vector<ApplyResult> results;
+        results.reserve(changes.size());
+        for (auto const &change : changes)
+        {
+            if (change.target->name == "master")
+            {
+                set_master_volume(change.volume);
+                results.emplace_back(ApplyResult::APPLIED);
+            }
+            else if (change.target->name == "mic")
+            {
+                set_microphone_volume(change.volume);
+                results.emplace_back(ApplyResult::APPLIED);
+            }
+            else if (change.target->applications.empty())
+            {
+                endpoint app(*change.target);
+                app.set_volume = change.volume;
+                results.emplace_back(set_application_volume(app) ? ApplyResult::APPLIED : ApplyResult::NOT_FOUND);
+            }
+            else
+            {
+                // Plain names of the group, patterns need a backend that overrides this
+                bool applied = false;
+                for (auto const &name : change.target->applications)
+                {
+                    if (endpoint_matcher_c::is_pattern(name))
+                    {
+                        continue;
+                    }
+                    endpoint app(name);
+                    app.set_volume = change.volume;
+                    applied = set_application_volume(app) || applied;
+                }
+                results.emplace_back(applied ? ApplyResult::APPLIED : ApplyResult::NOT_FOUND);
+            }
+        }
+        return results;
+    }
+
+    uint64_t os_media_interface_c::take_failed()
+    {
+        return 0;
+    }
+
+    std::unique_ptr<os_media_interface_c> create_media_interface()
+    {
+#ifdef _WIN32
+        return std::make_unique<windows_media_interface_c>();
+#elif defined(AUDIO_MIXER_HAVE_PULSE)
+        return std::make_unique<pulse_media_interface_c>();
+#else
+        return nullptr;
+#endif
+    }
+
+} // end of audio_mixer namespace
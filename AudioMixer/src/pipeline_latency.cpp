@@ -0,0 +1,75 @@
+#include "pipeline_latency.hpp"
+
+#include <cstdio>
+
+namespace audio_mixer
+{
+    namespace
+    {
+        std::string format_histogram(std::string const &name, latency_histogram_c const &histogram)
+        {
+            char line[160];
+            std::snprintf(line, sizeof(line), "%-10s n=%-9llu p50=%.1fus p99=%.1fus p99.9=%.1fus max=%.1fus",
+                          name.c_str(), static_cast<unsigned long long>(histogram.count()),
+                          static_cast<double>(histogram.value_at_percentile(50.0)) / 1000.0,
+                          static_cast<double>(histogram.value_at_percentile(99.0)) / 1000.0,
+                          static_cast<double>(histogram.value_at_percentile(99.9)) / 1000.0,
+                          static_cast<double>(histogram.max()) / 1000.0);
+            return line;
+        }
+    } // namespace
+
+    char const *stage_name(Stage stage)
+    {
+        switch (stage)
+        {
+        case Stage::READ:
+            return "read";
+        case Stage::PARSE:
+            return "parse";
+        case Stage::PUSH:
+            return "push";
+        case Stage::PICKUP:
+            return "pickup";
+        case Stage::SCALE:
+            return "scale";
+        case Stage::APPLY:
+            return "apply";
+        case Stage::TOTAL:
+            return "total";
+        default:
+            return "unknown";
+        }
+    }
+
+    latency_histogram_c const &pipeline_latency_c::stage(Stage stage) const
+    {
+        return m_stages[static_cast<size_t>(stage)];
+    }
+
+    latency_histogram_c const &pipeline_latency_c::endpoint_histogram(size_t index) const
+    {
+        return m_endpoints.at(index);
+    }
+
+    std::string pipeline_latency_c::summary(std::vector<endpoint> const &endpoints) const
+    {
+        std::string out;
+        for (size_t i = 0; i < m_stages.size(); i++)
+        {
+            if (m_stages[i].count() != 0)
+            {
+                out += format_histogram(stage_name(static_cast<Stage>(i)), m_stages[i]) + "\n";
+            }
+        }
+        for (size_t i = 0; i < endpoints.size() && i < m_endpoints.size(); i++)
+        {
+            if (m_endpoints[i].count() != 0)
+            {
+                out += format_histogram(endpoints[i].name, m_endpoints[i]) + "\n";
+            }
+        }
+        return out;
+    }
+
+} // namespace audio_mixer
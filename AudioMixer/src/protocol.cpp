@@ -0,0 +1,169 @@
+#include "protocol.hpp"
+
+namespace audio_mixer
+{
+    namespace
+    {
+        constexpr size_t HEADER_SIZE = 2;
+        constexpr size_t CRC_SIZE = 2;
+
+        // Bytes needed for count 12-bit values packed two per three bytes
+        constexpr size_t packed_size(size_t count)
+        {
+            return (count * 12 + 7) / 8;
+        }
+
+        uint16_t unpack_12bit(uint8_t const *packed, size_t index)
+        {
+            uint8_t const *p = packed + (index * 12) / 8;
+            if (index % 2 == 0)
+            {
+                return static_cast<uint16_t>(p[0] | ((p[1] & 0x0F) << 8));
+            }
+            return static_cast<uint16_t>((p[0] >> 4) | (p[1] << 4));
+        }
+    } // namespace
+
+    uint16_t crc16_ccitt(uint8_t const *data, size_t length)
+    {
+        uint16_t crc = 0xFFFF;
+        for (size_t i = 0; i < length; i++)
+        {
+            crc ^= static_cast<uint16_t>(data[i] << 8);
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+            }
+        }
+        return crc;
+    }
+
+    size_t cobs_decode(uint8_t const *in, size_t length, uint8_t *out)
+    {
+        size_t read = 0;
+        size_t written = 0;
+        while (read < length)
+        {
+            uint8_t code = in[read++];
+            if (code == 0)
+            {
+                return 0; // Delimiters never appear inside a record
+            }
+            for (uint8_t i = 1; i < code; i++)
+            {
+                if (read >= length)
+                {
+                    return 0; // Truncated block
+                }
+                out[written++] = in[read++];
+            }
+            // Every block but a full (0xFF) one and the last one stands for a zero byte
+            if (code != 0xFF && read < length)
+            {
+                out[written++] = 0;
+            }
+        }
+        return written;
+    }
+
+    bool decode_packet(std::string_view record, packet_header &header, knob_frame &frame)
+    {
+        if (record.empty() || record.size() > AUDIO_MIXER_PACKET_MAX_SIZE)
+        {
+            return false;
+        }
+
+        uint8_t packet[AUDIO_MIXER_PACKET_MAX_SIZE];
+        size_t length = cobs_decode(reinterpret_cast<uint8_t const *>(record.data()), record.size(), packet);
+        if (length < HEADER_SIZE + CRC_SIZE)
+        {
+            return false;
+        }
+
+        size_t const body_end = length - CRC_SIZE;
+        uint16_t const crc = static_cast<uint16_t>(packet[body_end] | (packet[body_end + 1] << 8));
+        if (crc16_ccitt(packet, body_end) != crc)
+        {
+            return false;
+        }
+
+        header.type = static_cast<PacketType>(packet[0]);
+        header.sequence = packet[1];
+
+        uint8_t const *body = packet + HEADER_SIZE;
+        size_t const body_size = body_end - HEADER_SIZE;
+        switch (header.type)
+        {
+        case PacketType::HEARTBEAT:
+            return body_size == 0;
+
+        case PacketType::FULL:
+        {
+            if (body_size < 1)
+            {
+                return false;
+            }
+            uint8_t const count = body[0];
+            if (count == 0 || count > AUDIO_MIXER_MAX_KNOBS || body_size != 1 + packed_size(count))
+            {
+                return false;
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                frame.values[i] = unpack_12bit(body + 1, i);
+            }
+            frame.count = count;
+            frame.bits = 12;
+            return true;
+        }
+
+        case PacketType::DELTA:
+        {
+            if (body_size < 1)
+            {
+                return false;
+            }
+            uint8_t const count = body[0];
+            size_t const mask_size = (count + 7) / 8;
+            if (count == 0 || count != frame.count || body_size < 1 + mask_size)
+            {
+                return false;
+            }
+
+            uint8_t const *mask = body + 1;
+            size_t changed = 0;
+            for (size_t i = 0; i < mask_size * 8; i++)
+            {
+                if (mask[i / 8] & (1u << (i % 8)))
+                {
+                    if (i >= count)
+                    {
+                        return false; // Bit set for a knob that does not exist
+                    }
+                    ++changed;
+                }
+            }
+            if (body_size != 1 + mask_size + packed_size(changed))
+            {
+                return false;
+            }
+
+            uint8_t const *packed = mask + mask_size;
+            size_t next = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (mask[i / 8] & (1u << (i % 8)))
+                {
+                    frame.values[i] = unpack_12bit(packed, next++);
+                }
+            }
+            frame.bits = 12;
+            return true;
+        }
+
+        default:
+            return false;
+        }
+    }
+
+} // namespace audio_mixer
@@ -0,0 +1,646 @@
+#include "pulse_media_interface.hpp"
+
+#ifdef AUDIO_MIXER_HAVE_PULSE
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "logger.hpp"
+
+namespace audio_mixer
+{
+    namespace
+    {
+        constexpr char const *CLIENT_NAME = "AudioMixer";
+        // Connection attempts are spaced out while the sound server is away.
+        constexpr std::chrono::seconds RECONNECT_INTERVAL(2);
+
+        // Callbacks run on the mainloop thread with the lock held, everyone else takes it.
+        class mainloop_lock_c
+        {
+        public:
+            explicit mainloop_lock_c(pa_threaded_mainloop *mainloop)
+                : m_mainloop(mainloop)
+            {
+                pa_threaded_mainloop_lock(m_mainloop);
+            }
+
+            ~mainloop_lock_c()
+            {
+                pa_threaded_mainloop_unlock(m_mainloop);
+            }
+
+        private:
+            pa_threaded_mainloop *m_mainloop;
+        };
+
+        pa_volume_t to_pa_volume(float volume)
+        {
+            return static_cast<pa_volume_t>(std::lround(std::clamp(volume, 0.0f, 1.0f) * PA_VOLUME_NORM));
+        }
+
+        // A single channel volume is applied to every channel by the server
+        pa_cvolume make_cvolume(uint8_t channels, float volume)
+        {
+            pa_cvolume cvolume;
+            pa_cvolume_set(&cvolume, channels == 0 ? 1 : channels, to_pa_volume(volume));
+            return cvolume;
+        }
+
+        std::string property(pa_proplist *properties, char const *key)
+        {
+            char const *value = properties ? pa_proplist_gets(properties, key) : nullptr;
+            return value ? value : "";
+        }
+    } // namespace
+
+    pulse_media_interface_c::pulse_media_interface_c()
+        : m_mainloop(pa_threaded_mainloop_new()),
+          m_context(nullptr),
+          m_ready(false),
+          m_sink{"", PA_INVALID_INDEX, 0, false, false},
+          m_source{"", PA_INVALID_INDEX, 0, false, false},
+          m_failed(0)
+    {
+        for (size_t i = 0; i < m_targets.size(); i++)
+        {
+            m_targets[i] = operation_target{this, i};
+        }
+        if (!m_mainloop)
+        {
+            audio_mixer::log_error("Failed to create PulseAudio mainloop.");
+            throw std::runtime_error("Failed to create PulseAudio mainloop");
+        }
+        if (pa_threaded_mainloop_start(m_mainloop) < 0)
+        {
+            pa_threaded_mainloop_free(m_mainloop);
+            audio_mixer::log_error("Failed to start PulseAudio mainloop.");
+            throw std::runtime_error("Failed to start PulseAudio mainloop");
+        }
+
+        this->initialize();
+    }
+
+    pulse_media_interface_c::~pulse_media_interface_c()
+    {
+        {
+            mainloop_lock_c lock(m_mainloop);
+            disconnect();
+        }
+        pa_threaded_mainloop_stop(m_mainloop);
+        pa_threaded_mainloop_free(m_mainloop);
+    }
+
+    void pulse_media_interface_c::initialize()
+    {
+        mainloop_lock_c lock(m_mainloop);
+        connect();
+    }
+
+    void pulse_media_interface_c::set_master_volume(float volume)
+    {
+        set_device_volume(true, volume);
+    }
+
+    void pulse_media_interface_c::set_microphone_volume(float volume)
+    {
+        set_device_volume(false, volume);
+    }
+
+    std::vector<endpoint> pulse_media_interface_c::get_endpoints()
+    {
+        std::vector<endpoint> endpoints;
+        mainloop_lock_c lock(m_mainloop);
+        ensure_connected();
+
+        endpoints.reserve(m_streams.size());
+        for (auto const &entry : m_streams)
+        {
+            endpoint app(entry.second.name);
+            app.current_volume = static_cast<float>(entry.second.volume) / static_cast<float>(PA_VOLUME_NORM);
+            app.pid = entry.second.pid;
+            endpoints.emplace_back(app);
+        }
+        return endpoints;
+    }
+
+    bool pulse_media_interface_c::set_application_volume(endpoint const &app)
+    {
+        if (app.set_volume < 0.0f || app.set_volume > 1.0f)
+        {
+            audio_mixer::log_error("Volume must be between 0.0 and 1.0");
+            return false;
+        }
+
+        std::string const &key = app.key;
+        mainloop_lock_c lock(m_mainloop);
+        ensure_connected();
+        if (!m_ready)
+        {
+            return false;
+        }
+
+        bool found = false;
+        for (auto const &entry : m_streams)
+        {
+            if (entry.second.binary == key || entry.second.application == key)
+            {
+                send_stream_volume(entry.first, entry.second, app.set_volume, nullptr);
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            audio_mixer::log_error("No stream found for " + app.name);
+        }
+        return found;
+    }
+
+    void pulse_media_interface_c::set_matcher(std::shared_ptr<endpoint_matcher_c const> matcher)
+    {
+        mainloop_lock_c lock(m_mainloop);
+        os_media_interface_c::set_matcher(std::move(matcher));
+        for (auto &entry : m_streams)
+        {
+            entry.second.group = resolve_group(entry.second);
+        }
+        // The indexes belong to the previous endpoints
+        m_failed.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t pulse_media_interface_c::take_failed()
+    {
+        if (m_failed.load(std::memory_order_relaxed) == 0)
+        {
+            return 0;
+        }
+        return m_failed.exchange(0, std::memory_order_acq_rel);
+    }
+
+    int pulse_media_interface_c::resolve_group(stream const &s) const
+    {
+        if (!m_matcher)
+        {
+            return endpoint_matcher_c::NO_GROUP;
+        }
+        int group = m_matcher->match(s.binary);
+        if (group == endpoint_matcher_c::NO_GROUP)
+        {
+            group = m_matcher->match(s.application);
+        }
+        return group;
+    }
+
+    void pulse_media_interface_c::set_device_volume(bool sink, float volume)
+    {
+        if (volume < 0.0f || volume > 1.0f)
+        {
+            audio_mixer::log_error("Volume level must be between 0.0 and 1.0");
+            return;
+        }
+
+        mainloop_lock_c lock(m_mainloop);
+        ensure_connected();
+        send_device_volume(sink, volume, nullptr);
+    }
+
+    std::vector<ApplyResult> pulse_media_interface_c::set_volumes(std::vector<volume_change> const &changes)
+    {
+        std::vector<ApplyResult> results(changes.size(), ApplyResult::NOT_FOUND);
+        mainloop_lock_c lock(m_mainloop);
+        ensure_connected();
+        if (!m_ready)
+        {
+            std::fill(results.begin(), results.end(), ApplyResult::FAILED);
+            return results;
+        }
+
+        // Queued writes count as applied, a rejected one is reported later through take_failed()
+        auto const sent = [&results](size_t i, bool ok) {
+            if (!ok)
+            {
+                results[i] = ApplyResult::FAILED;
+            }
+            else if (results[i] == ApplyResult::NOT_FOUND)
+            {
+                results[i] = ApplyResult::APPLIED;
+            }
+        };
+        auto const target = [this](volume_change const &change) {
+            return change.index < m_targets.size() ? &m_targets[change.index] : nullptr;
+        };
+
+        // Applications by name or group, so the streams are walked once for the whole batch
+        std::unordered_map<std::string_view, size_t> applications;
+        std::vector<int> groups(m_matcher ? m_matcher->size() : 0, -1);
+        bool any_group = false;
+        for (size_t i = 0; i < changes.size(); i++)
+        {
+            auto const &change = changes[i];
+            if (change.volume < 0.0f || change.volume > 1.0f)
+            {
+                audio_mixer::log_error("Volume must be between 0.0 and 1.0");
+                results[i] = ApplyResult::FAILED;
+            }
+            else if (change.target->name == "master" || change.target->name == "mic")
+            {
+                sent(i, send_device_volume(change.target->name == "master", change.volume, target(change)));
+            }
+            else if (change.index < groups.size())
+            {
+                groups[change.index] = static_cast<int>(i);
+                any_group = true;
+            }
+            else
+            {
+                applications.emplace(change.target->key, i);
+            }
+        }
+
+        if (any_group)
+        {
+            for (auto const &entry : m_streams)
+            {
+                int const group = entry.second.group;
+                if (group != endpoint_matcher_c::NO_GROUP && groups[group] >= 0)
+                {
+                    auto const &change = changes[groups[group]];
+                    sent(groups[group], send_stream_volume(entry.first, entry.second, change.volume, target(change)));
+                }
+            }
+        }
+        if (!applications.empty())
+        {
+            for (auto const &entry : m_streams)
+            {
+                auto it = applications.find(entry.second.binary);
+                if (it == applications.end())
+                {
+                    it = applications.find(entry.second.application);
+                }
+                if (it != applications.end())
+                {
+                    auto const &change = changes[it->second];
+                    sent(it->second, send_stream_volume(entry.first, entry.second, change.volume, target(change)));
+                }
+            }
+        }
+        return results;
+    }
+
+    bool pulse_media_interface_c::send_device_volume(bool sink, float volume, operation_target *target)
+    {
+        device &selected = sink ? m_sink : m_source;
+        if (!m_ready || selected.name.empty())
+        {
+            return false;
+        }
+
+        pa_context_success_cb_t const reply = target ? on_applied : on_success;
+        void *const userdata = target ? static_cast<void *>(target) : this;
+        pa_cvolume cvolume = make_cvolume(selected.channels, volume);
+        pa_operation *op = sink
+            ? pa_context_set_sink_volume_by_name(m_context, selected.name.c_str(), &cvolume, reply, userdata)
+            : pa_context_set_source_volume_by_name(m_context, selected.name.c_str(), &cvolume, reply, userdata);
+        if (!op)
+        {
+            return false;
+        }
+        pa_operation_unref(op);
+
+        // The microphone is muted at zero like on Windows
+        if (!sink && (volume == 0.0f) != selected.muted)
+        {
+            op = pa_context_set_source_mute_by_name(m_context, selected.name.c_str(), volume == 0.0f, reply, userdata);
+            if (!op)
+            {
+                return false;
+            }
+            pa_operation_unref(op);
+            // Our own change, so the next volume does not send it again before the info arrives
+            selected.muted = volume == 0.0f;
+        }
+        return true;
+    }
+
+    bool pulse_media_interface_c::send_stream_volume(uint32_t index, stream const &s, float volume,
+                                                     operation_target *target)
+    {
+        pa_context_success_cb_t const reply = target ? on_applied : on_success;
+        void *const userdata = target ? static_cast<void *>(target) : this;
+        pa_cvolume cvolume = make_cvolume(s.channels, volume);
+        pa_operation *op = pa_context_set_sink_input_volume(m_context, index, &cvolume, reply, userdata);
+        if (!op)
+        {
+            return false;
+        }
+        pa_operation_unref(op);
+
+        // Muted at zero like the Windows sessions, unmuted when turned back up
+        if ((volume == 0.0f) != s.muted)
+        {
+            op = pa_context_set_sink_input_mute(m_context, index, volume == 0.0f, reply, userdata);
+            if (!op)
+            {
+                return false;
+            }
+            pa_operation_unref(op);
+        }
+        return true;
+    }
+
+    void pulse_media_interface_c::connect()
+    {
+        m_last_connect = std::chrono::steady_clock::now();
+        m_context = pa_context_new(pa_threaded_mainloop_get_api(m_mainloop), CLIENT_NAME);
+        if (!m_context)
+        {
+            audio_mixer::log_error("Failed to create PulseAudio context.");
+            return;
+        }
+
+        pa_context_set_state_callback(m_context, on_state, this);
+        // NOFAIL keeps waiting for a server that is not running yet
+        if (pa_context_connect(m_context, nullptr, PA_CONTEXT_NOFAIL, nullptr) < 0)
+        {
+            audio_mixer::log_error(std::string("Failed to connect to the sound server: ") +
+                                   pa_strerror(pa_context_errno(m_context)));
+        }
+    }
+
+    void pulse_media_interface_c::disconnect()
+    {
+        if (m_context)
+        {
+            pa_context_set_state_callback(m_context, nullptr, nullptr);
+            pa_context_set_subscribe_callback(m_context, nullptr, nullptr);
+            pa_context_disconnect(m_context);
+            pa_context_unref(m_context);
+            m_context = nullptr;
+        }
+        m_ready = false;
+        m_streams.clear();
+        m_sink = device{"", PA_INVALID_INDEX, 0, false, false};
+        m_source = device{"", PA_INVALID_INDEX, 0, false, false};
+    }
+
+    void pulse_media_interface_c::ensure_connected()
+    {
+        if (m_context && PA_CONTEXT_IS_GOOD(pa_context_get_state(m_context)))
+        {
+            return;
+        }
+        if (std::chrono::steady_clock::now() - m_last_connect < RECONNECT_INTERVAL)
+        {
+            return;
+        }
+        audio_mixer::log_info("Reconnecting to the sound server");
+        disconnect();
+        connect();
+    }
+
+    void pulse_media_interface_c::request_server_info()
+    {
+        pa_operation *op = pa_context_get_server_info(m_context, on_server_info, this);
+        if (op)
+        {
+            pa_operation_unref(op);
+        }
+    }
+
+    // One request per device at a time, so a burst of change events costs one round trip
+    void pulse_media_interface_c::request_device_info(bool sink)
+    {
+        device &target = sink ? m_sink : m_source;
+        if (target.refreshing || target.index == PA_INVALID_INDEX)
+        {
+            return;
+        }
+        pa_operation *op = sink ? pa_context_get_sink_info_by_index(m_context, target.index, on_sink_info, this)
+                                : pa_context_get_source_info_by_index(m_context, target.index, on_source_info, this);
+        if (op)
+        {
+            target.refreshing = true;
+            pa_operation_unref(op);
+        }
+    }
+
+    void pulse_media_interface_c::store_stream(pa_sink_input_info const &info)
+    {
+        std::string binary = property(info.proplist, PA_PROP_APPLICATION_PROCESS_BINARY);
+        std::string application = property(info.proplist, PA_PROP_APPLICATION_NAME);
+        std::string pid = property(info.proplist, PA_PROP_APPLICATION_PROCESS_ID);
+
+        stream s;
+        s.name = !binary.empty() ? binary : (!application.empty() ? application : (info.name ? info.name : ""));
+        s.binary = toLower(binary);
+        s.application = toLower(application);
+
+        // Info arrives again on every stream change, the group only depends on the names
+        auto known = m_streams.find(info.index);
+        if (known != m_streams.end() && known->second.binary == s.binary &&
+            known->second.application == s.application)
+        {
+            s.group = known->second.group;
+        }
+        else
+        {
+            s.group = resolve_group(s);
+        }
+        s.pid = static_cast<uint32_t>(std::strtoul(pid.c_str(), nullptr, 10));
+        s.channels = info.volume.channels;
+        s.volume = pa_cvolume_avg(&info.volume);
+        s.muted = info.mute != 0;
+        m_streams[info.index] = std::move(s);
+    }
+
+    void pulse_media_interface_c::on_state(pa_context *context, void *userdata)
+    {
+        auto *self = static_cast<pulse_media_interface_c *>(userdata);
+        if (context != self->m_context)
+        {
+            return;
+        }
+
+        switch (pa_context_get_state(context))
+        {
+        case PA_CONTEXT_READY:
+        {
+            audio_mixer::log_info("Connected to the sound server");
+            self->m_ready = true;
+            pa_context_set_subscribe_callback(context, on_event, self);
+            auto mask = static_cast<pa_subscription_mask_t>(PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_SOURCE |
+                                                            PA_SUBSCRIPTION_MASK_SINK_INPUT |
+                                                            PA_SUBSCRIPTION_MASK_SERVER);
+            pa_operation *op = pa_context_subscribe(context, mask, on_success, self);
+            if (op)
+            {
+                pa_operation_unref(op);
+            }
+            self->request_server_info();
+            op = pa_context_get_sink_input_info_list(context, on_sink_input_info, self);
+            if (op)
+            {
+                pa_operation_unref(op);
+            }
+            break;
+        }
+        case PA_CONTEXT_FAILED:
+        case PA_CONTEXT_TERMINATED:
+            audio_mixer::log_warning("Lost the connection to the sound server");
+            self->m_ready = false;
+            break;
+        default:
+            break;
+        }
+    }
+
+    void pulse_media_interface_c::on_event(
+        pa_context *context, pa_subscription_event_type_t type, uint32_t index, void *userdata)
+    {
+        auto *self = static_cast<pulse_media_interface_c *>(userdata);
+        if (context != self->m_context)
+        {
+            return;
+        }
+
+        unsigned const facility = type & PA_SUBSCRIPTION_EVENT_FACILITY_MASK;
+        unsigned const kind = type & PA_SUBSCRIPTION_EVENT_TYPE_MASK;
+        if (facility == PA_SUBSCRIPTION_EVENT_SINK_INPUT)
+        {
+            if (kind == PA_SUBSCRIPTION_EVENT_REMOVE)
+            {
+                self->m_streams.erase(index);
+                return;
+            }
+            pa_operation *op = pa_context_get_sink_input_info(context, index, on_sink_input_info, self);
+            if (op)
+            {
+                pa_operation_unref(op);
+            }
+        }
+        else if (facility == PA_SUBSCRIPTION_EVENT_SERVER)
+        {
+            // The default sink or source may have changed
+            self->request_server_info();
+        }
+        else if (kind == PA_SUBSCRIPTION_EVENT_CHANGE &&
+                 ((facility == PA_SUBSCRIPTION_EVENT_SINK && index == self->m_sink.index) ||
+                  (facility == PA_SUBSCRIPTION_EVENT_SOURCE && index == self->m_source.index)))
+        {
+            // Channels or mute state of a default device may have changed, other devices
+            // are not used. Our own volume writes land here too, so only that device is read.
+            self->request_device_info(facility == PA_SUBSCRIPTION_EVENT_SINK);
+        }
+    }
+
+    void pulse_media_interface_c::on_server_info(pa_context *context, pa_server_info const *info, void *userdata)
+    {
+        auto *self = static_cast<pulse_media_interface_c *>(userdata);
+        if (context != self->m_context || !info)
+        {
+            return;
+        }
+
+        self->m_sink.name = info->default_sink_name ? info->default_sink_name : "";
+        self->m_source.name = info->default_source_name ? info->default_source_name : "";
+
+        pa_operation *op = nullptr;
+        if (!self->m_sink.name.empty())
+        {
+            op = pa_context_get_sink_info_by_name(context, self->m_sink.name.c_str(), on_sink_info, self);
+            if (op)
+            {
+                pa_operation_unref(op);
+            }
+        }
+        if (!self->m_source.name.empty())
+        {
+            op = pa_context_get_source_info_by_name(context, self->m_source.name.c_str(), on_source_info, self);
+            if (op)
+            {
+                pa_operation_unref(op);
+            }
+        }
+    }
+
+    void pulse_media_interface_c::on_sink_info(pa_context *context, pa_sink_info const *info, int eol, void *userdata)
+    {
+        auto *self = static_cast<pulse_media_interface_c *>(userdata);
+        if (context != self->m_context)
+        {
+            return;
+        }
+        if (eol != 0)
+        {
+            self->m_sink.refreshing = false;
+            return;
+        }
+        if (!info || self->m_sink.name != info->name)
+        {
+            return;
+        }
+        self->m_sink.index = info->index;
+        self->m_sink.channels = info->volume.channels;
+        self->m_sink.muted = info->mute != 0;
+    }
+
+    void pulse_media_interface_c::on_source_info(
+        pa_context *context, pa_source_info const *info, int eol, void *userdata)
+    {
+        auto *self = static_cast<pulse_media_interface_c *>(userdata);
+        if (context != self->m_context)
+        {
+            return;
+        }
+        if (eol != 0)
+        {
+            self->m_source.refreshing = false;
+            return;
+        }
+        if (!info || self->m_source.name != info->name)
+        {
+            return;
+        }
+        self->m_source.index = info->index;
+        self->m_source.channels = info->volume.channels;
+        self->m_source.muted = info->mute != 0;
+    }
+
+    void pulse_media_interface_c::on_sink_input_info(
+        pa_context *context, pa_sink_input_info const *info, int eol, void *userdata)
+    {
+        auto *self = static_cast<pulse_media_interface_c *>(userdata);
+        if (context != self->m_context || eol != 0 || !info)
+        {
+            return; // End of list, or the stream went away before the reply
+        }
+        self->store_stream(*info);
+    }
+
+    void pulse_media_interface_c::on_success(pa_context *context, int success, void *userdata)
+    {
+        if (!success)
+        {
+            audio_mixer::log_warning(std::string("Sound server operation failed: ") +
+                                     pa_strerror(pa_context_errno(context)));
+        }
+    }
+
+    void pulse_media_interface_c::on_applied(pa_context *context, int success, void *userdata)
+    {
+        auto *target = static_cast<operation_target *>(userdata);
+        if (!success)
+        {
+            // set_volumes() already reported it applied, the mixer sends it again once it takes this
+            target->self->m_failed.fetch_or(uint64_t{1} << target->index, std::memory_order_release);
+            audio_mixer::log_warning(std::string("Sound server rejected a volume: ") +
+                                     pa_strerror(pa_context_errno(context)));
+        }
+    }
+
+} // end of audio_mixer namespace
+
+#endif // AUDIO_MIXER_HAVE_PULSE
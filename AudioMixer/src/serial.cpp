@@ -1,5 +1,8 @@
 #include "serial.hpp"
 #include "logger.hpp"
+#include "metrics.hpp"
+#include "pipeline_latency.hpp"
+#include "trace.hpp"
 
 #ifdef _WIN32
 #include <devguid.h>
@@ -20,11 +23,35 @@ namespace audio_mixer
 
     namespace
     {
-        const std::string HEARTBEAT = "AUDIOMIXER_V1_HEARTBEAT";
-        const std::string HANDSHAKE_KEY = "AUDIOMIXER_HELLO";
-        const std::string HANDSHAKE_RESPONSE = "AUDIOMIXER_READY";
-        constexpr int HANDSHAKE_TIMEOUT_MS = 1000;
+        const std::string HEARTBEAT_RESPONSE = std::string(HEARTBEAT) + "\n";
+        // The device may reset when the port opens and sends its handshake once a second.
+        constexpr int HANDSHAKE_TIMEOUT_MS = 3000;
         constexpr int HEARTBEAT_TIMEOUT_MS = 1500;
+        constexpr int SESSION_EXIT_CHECK_MS = 250;
+        // Give udev a moment to finish setting up a new device node before opening it.
+        constexpr int HOTPLUG_SETTLE_MS = 100;
+        // A device that is present but missed the handshake is probed again this often.
+        constexpr int PROBE_RETRY_MS = 15000;
+
+        const char *DEVICE_DIRECTORY = "/dev/";
+        const char *SERIAL_PORT_PREFIXES[] = {"ttyACM", "ttyUSB", "cu.usb"};
+
+        bool starts_with(std::string_view text, std::string_view prefix)
+        {
+            return text.size() >= prefix.size() && text.compare(0, prefix.size(), prefix) == 0;
+        }
+
+        bool is_serial_port_name(std::string_view name)
+        {
+            for (auto prefix : SERIAL_PORT_PREFIXES)
+            {
+                if (starts_with(name, prefix))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
     } // namespace
 
     // Cross-platform serial port enumeration
@@ -54,7 +81,7 @@ namespace audio_mixer
                     if (start != std::string::npos && end != std::string::npos)
                     {
                         ports.emplace_back(name.substr(start, end - start));
-                        audio_mixer::log_debug("Found serial port: " + ports.back());
+                        AUDIO_MIXER_LOG_DEBUG("Found serial port: ", ports.back());
                     }
                 }
             }
@@ -62,22 +89,15 @@ namespace audio_mixer
         SetupDiDestroyDeviceInfoList(hDevInfo);
 #else
         // INFO: UNTESTED: This code is for Linux/macOS
-        const char *dirs[] = {"/dev/"};
-        const char *prefixes[] = {"ttyACM", "ttyUSB", "cu.usb"};
-        for (auto dir : dirs)
+        DIR *dp = opendir(DEVICE_DIRECTORY);
+        if (dp)
         {
-            DIR *dp = opendir(dir);
-            if (!dp)
-                continue;
             struct dirent *ep;
             while ((ep = readdir(dp)))
             {
-                for (auto prefix : prefixes)
+                if (is_serial_port_name(ep->d_name))
                 {
-                    if (strncmp(ep->d_name, prefix, strlen(prefix)) == 0)
-                    {
-                        ports.emplace_back(std::string(dir) + ep->d_name);
-                    }
+                    ports.emplace_back(std::string(DEVICE_DIRECTORY) + ep->d_name);
                 }
             }
             closedir(dp);
@@ -86,210 +106,411 @@ namespace audio_mixer
         return ports;
     }
 
-    // Read a line with timeout
-    // This function uses async_read_until and a timer to implement the timeout
-    bool read_line_with_timeout(
-        boost::asio::io_context &io_ctx, boost::asio::serial_port &serial, std::string &line, int timeout_ms)
+    // Constructor/Destructor
+    serial_connection_c::serial_connection_c(
+        boost::asio::io_context &context, std::shared_ptr<frame_mailbox_c> frames, baud_rate_t const &baud)
+        : m_context(context),
+          m_serial(context),
+          m_port(""),
+          m_baud(baud),
+          m_frames(frames),
+          m_prober(context, baud),
+          m_hotplug(context),
+          m_protocol(Protocol::TEXT),
+          m_heartbeat_timer(context),
+          m_read_ns(0),
+          m_session(0),
+          m_session_counter(0),
+          m_write_pending(false),
+          m_sequence_valid(false),
+          m_last_sequence(0),
+          m_dropped_frames(0),
+          m_corrupt_packets(0),
+          m_session_active(false),
+          m_rescan(false)
+    {
+        // Connection handled in run()
+    }
+
+    serial_connection_c::~serial_connection_c()
+    {
+        if (m_serial.is_open())
+            m_serial.close();
+        m_context.stop();
+    }
+
+    // Main read loop: run an asynchronous read session until the device goes away
+    void serial_connection_c::main_read_loop(bool &exit_app)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_session_mutex);
+            m_session_active = true;
+        }
+        boost::asio::post(m_context, [this]() { begin_session(); });
+
+        std::unique_lock<std::mutex> lock(m_session_mutex);
+        while (!exit_app && m_session_active)
+        {
+            m_session_cv.wait_for(lock, std::chrono::milliseconds(SESSION_EXIT_CHECK_MS));
+        }
+
+        if (m_session_active)
+        {
+            // Exit requested, the port may only be closed from the io_context thread.
+            boost::asio::post(m_context, [this]() { end_session(); });
+            m_session_cv.wait_for(lock, std::chrono::milliseconds(SESSION_EXIT_CHECK_MS),
+                                  [this]() { return !m_session_active; });
+        }
+    }
+
+    void serial_connection_c::begin_session()
+    {
+        m_session = ++m_session_counter;
+        m_session_port = m_port;
+        m_framer.clear();
+        m_framer.set_delimiter(m_protocol == Protocol::BINARY_V2 ? '\0' : '\n');
+        m_write_pending = false;
+        m_sequence_valid = false;
+        m_frame.count = 0; // Deltas are ignored until the first keyframe
+        m_dropped_frames = 0;
+        m_corrupt_packets = 0;
+        m_last_heartbeat = std::chrono::steady_clock::now();
+
+        trace_c::instance().event(TraceEvent::CONNECT, pipeline_latency_c::now_ns());
+        auto &metrics = metrics_c::instance();
+        metrics.set(Gauge::CONNECTED, 1);
+        if (m_session > 1)
+        {
+            metrics.add(Counter::RECONNECTS);
+        }
+        start_read(m_session);
+        start_heartbeat_timer(m_session);
+    }
+
+    void serial_connection_c::end_session()
+    {
+        if (m_session == 0)
+        {
+            return;
+        }
+        m_session = 0; // Late handlers from this session are ignored from here on
+        trace_c::instance().event(TraceEvent::DISCONNECT, pipeline_latency_c::now_ns());
+        metrics_c::instance().set(Gauge::CONNECTED, 0);
+        m_heartbeat_timer.cancel();
+
+        if (m_serial.is_open())
+        {
+            boost::system::error_code ec;
+            m_serial.close(ec);
+            audio_mixer::log_error("Serial port closed: " + m_port);
+        }
+        if (m_protocol == Protocol::BINARY_V2)
+        {
+            audio_mixer::log_info("Session on " + m_port + " dropped " + std::to_string(m_dropped_frames) +
+                                  " frames, " + std::to_string(m_corrupt_packets) + " corrupt packets");
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_session_mutex);
+            m_session_active = false;
+        }
+        m_session_cv.notify_all();
+    }
+
+    void serial_connection_c::start_read(uint64_t session)
     {
-        using namespace boost;
-        auto buf = std::make_shared<asio::streambuf>();
-        auto timer = std::make_shared<asio::deadline_timer>(io_ctx);
-        auto data_ready = std::make_shared<bool>(false);
-        auto ec = std::make_shared<system::error_code>();
-
-        asio::async_read_until(serial, *buf, "\n",
-                               [ec, data_ready, timer](const system::error_code &error, std::size_t)
-                               {
-                                   *ec = error;
-                                   *data_ready = true;
-                                   timer->cancel();
-                               });
-
-        timer->expires_from_now(boost::posix_time::milliseconds(timeout_ms));
-        timer->async_wait(
-            [data_ready, &serial](const system::error_code &error)
+        m_serial.async_read_some(
+            boost::asio::buffer(m_framer.write_ptr(), m_framer.write_space()),
+            [this, session](boost::system::error_code const &ec, std::size_t count)
             {
-                if (!error && !*data_ready)
+                if (session != m_session)
                 {
-                    serial.cancel();
+                    return;
+                }
+                if (ec)
+                {
+                    audio_mixer::log_error("main_read_loop: read error: " + ec.message());
+                    end_session();
+                    return;
+                }
+
+                m_read_ns = pipeline_latency_c::now_ns();
+                m_framer.commit(count);
+                m_framer.for_each_record([this](std::string_view record) { handle_record(record); });
+
+                if (session == m_session)
+                {
+                    start_read(session);
                 }
             });
+    }
 
-        io_ctx.reset();
-        io_ctx.run();
+    void serial_connection_c::start_heartbeat_timer(uint64_t session)
+    {
+        m_heartbeat_timer.expires_after(std::chrono::milliseconds(HEARTBEAT_TIMEOUT_MS / 2));
+        m_heartbeat_timer.async_wait(
+            [this, session](boost::system::error_code const &ec)
+            {
+                if (ec || session != m_session)
+                {
+                    return;
+                }
+                if (std::chrono::steady_clock::now() - m_last_heartbeat >
+                    std::chrono::milliseconds(HEARTBEAT_TIMEOUT_MS))
+                {
+                    audio_mixer::log_warning("Lost heartbeat, serial device disconnected from port: " + m_port);
+                    end_session();
+                    return;
+                }
+                start_heartbeat_timer(session);
+            });
+    }
 
-        if (*data_ready && !*ec)
+    void serial_connection_c::handle_record(std::string_view record)
+    {
+        if (m_protocol == Protocol::BINARY_V2)
+        {
+            handle_packet(record);
+        }
+        else
         {
-            std::istream is(buf.get());
-            std::getline(is, line);
-            return true;
+            handle_line(record);
         }
-        return false;
     }
 
-    // Update try_connect_and_handshake to use an open serial port:
-    bool serial_connection_c::try_connect_and_handshake(boost::asio::serial_port &serial, const std::string &port)
+    void serial_connection_c::handle_line(std::string_view line)
     {
-        boost::asio::io_context io_ctx;
-        std::string line;
-        if (read_line_with_timeout(io_ctx, serial, line, HANDSHAKE_TIMEOUT_MS))
+        // remove trailing carriage return
+        if (!line.empty() && line.back() == '\r')
         {
-            audio_mixer::log_debug("Received handshake line: " + line);
-            if (line.find(HANDSHAKE_KEY) != std::string::npos)
-            {
-                std::string response = HANDSHAKE_RESPONSE + "\n";
-                boost::asio::write(serial, boost::asio::buffer(response));
-                audio_mixer::log_info("Handshake successful on port: " + port);
-                return true;
-            }
-            else
+            line.remove_suffix(1);
+        }
+        metrics_c::instance().add(Counter::RECORDS_RECEIVED);
+
+        uint64_t const parse_start = pipeline_latency_c::now_ns();
+        if (starts_with(line, HEARTBEAT))
+        {
+            acknowledge_heartbeat();
+        }
+        else if (parse_frame(line, 0, m_frame))
+        {
+            uint64_t const parse_end = pipeline_latency_c::now_ns();
+            AUDIO_MIXER_LOG_DEBUG("Data received from serial port: ", m_port, " - ", line);
+            publish_frame(parse_start, parse_end);
+        }
+        else
+        {
+            metrics_c::instance().add(Counter::FRAMES_DISCARDED);
+            trace_c::instance().event(TraceEvent::DISCARD, m_read_ns);
+            AUDIO_MIXER_LOG_DEBUG("Discarding malformed frame from serial port: ", m_port);
+        }
+    }
+
+    void serial_connection_c::handle_packet(std::string_view record)
+    {
+        if (record.empty())
+        {
+            return; // Resync delimiter
+        }
+        auto &metrics = metrics_c::instance();
+        metrics.add(Counter::RECORDS_RECEIVED);
+
+        uint64_t const parse_start = pipeline_latency_c::now_ns();
+        packet_header header;
+        if (!decode_packet(record, header, m_frame))
+        {
+            ++m_corrupt_packets;
+            metrics.add(Counter::FRAMES_DISCARDED);
+            trace_c::instance().event(TraceEvent::DISCARD, m_read_ns);
+            AUDIO_MIXER_LOG_DEBUG("Discarding corrupt or out-of-sync packet from serial port: ", m_port);
+            return;
+        }
+
+        // Heartbeats and frames share one sequence counter, so any gap is a lost packet.
+        if (m_sequence_valid)
+        {
+            uint8_t gap = static_cast<uint8_t>(header.sequence - m_last_sequence - 1);
+            m_dropped_frames += gap;
+            if (gap != 0)
             {
-                audio_mixer::log_debug("Invalid handshake response on port: " + port);
+                metrics.add(Counter::FRAMES_LOST, gap);
             }
         }
-        return false;
+        m_last_sequence = header.sequence;
+        m_sequence_valid = true;
+
+        switch (header.type)
+        {
+        case PacketType::HEARTBEAT:
+            acknowledge_heartbeat();
+            break;
+        case PacketType::FULL:
+        case PacketType::DELTA:
+            // m_frame holds the merged state, so publishing it never loses a delta.
+            publish_frame(parse_start, pipeline_latency_c::now_ns());
+            break;
+        }
     }
 
-    // Constructor/Destructor
-    serial_connection_c::serial_connection_c(
-        boost::asio::io_context &context, std::shared_ptr<stack_c> stack, baud_rate_t const &baud)
-        : m_context(context), m_serial(context), m_data_stack(stack), m_port(""), m_baud(baud)
+    void serial_connection_c::publish_frame(uint64_t parse_start, uint64_t parse_end)
     {
-        // Connection handled in run()
+        auto &latency = pipeline_latency_c::instance();
+        latency.record(Stage::READ, parse_start - m_read_ns);
+        latency.record(Stage::PARSE, parse_end - parse_start);
+
+        m_frame.received_ns = m_read_ns;
+        m_frame.published_ns = pipeline_latency_c::now_ns();
+        m_frames->publish(m_frame);
+        latency.record_since(Stage::PUSH, m_frame.published_ns);
+        metrics_c::instance().add(Counter::FRAMES_PARSED);
+        trace_c::instance().frame(m_frame, m_read_ns, parse_end - parse_start);
     }
 
-    serial_connection_c::~serial_connection_c()
+    void serial_connection_c::acknowledge_heartbeat()
     {
-        if (m_serial.is_open())
-            m_serial.close();
-        m_context.stop();
+        trace_c::instance().event(TraceEvent::HEARTBEAT, m_read_ns);
+        metrics_c::instance().add(Counter::HEARTBEATS);
+        // Skip the echo if the previous one is still being written, one ack is enough.
+        if (!m_write_pending)
+        {
+            m_write_pending = true;
+            uint64_t session = m_session;
+            boost::asio::async_write(
+                m_serial, boost::asio::buffer(HEARTBEAT_RESPONSE),
+                [this, session](boost::system::error_code const &ec, std::size_t)
+                {
+                    if (session != m_session)
+                    {
+                        return;
+                    }
+                    m_write_pending = false;
+                    if (ec)
+                    {
+                        audio_mixer::log_error("main_read_loop: heartbeat write error: " + ec.message());
+                        end_session();
+                    }
+                });
+        }
+        m_last_heartbeat = std::chrono::steady_clock::now();
+        AUDIO_MIXER_LOG_DEBUG("Heartbeat received from serial port: ", m_port, " at:",
+                              std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  m_last_heartbeat.time_since_epoch())
+                                  .count());
     }
 
-    // Main read loop: wait for heartbeat and process data
-    void serial_connection_c::main_read_loop(bool &exit_app)
+    // Hotplug events from the device directory, runs on the io_context thread.
+    void serial_connection_c::handle_device_event(std::string const &name, directory_watcher_c::Event event)
     {
-        auto last_heartbeat = std::chrono::steady_clock::now();
-        boost::asio::streambuf buf;
-        std::istream is(&buf);
-
-        bool disconnected_logged = false;
+        if (event == directory_watcher_c::Event::RESCAN)
+        {
+            std::lock_guard<std::mutex> lock(m_session_mutex);
+            m_rescan = true;
+            m_session_cv.notify_all();
+            return;
+        }
+        if (!is_serial_port_name(name))
+        {
+            return;
+        }
 
-        while (!exit_app && m_serial.is_open())
+        std::string path = DEVICE_DIRECTORY + name;
+        if (event == directory_watcher_c::Event::ADDED)
         {
-            boost::system::error_code ec;
-            size_t n = boost::asio::read_until(m_serial, buf, "\n", ec);
-            if (ec)
-            {
-                audio_mixer::log_error("main_read_loop: read_until error: " + ec.message());
-                break;
-            }
+            AUDIO_MIXER_LOG_DEBUG("Serial device appeared: ", path);
+            std::lock_guard<std::mutex> lock(m_session_mutex);
+            m_arrived_ports.emplace_back(path);
+            m_session_cv.notify_all();
+        }
+        else if (event == directory_watcher_c::Event::REMOVED && m_session != 0 && path == m_session_port)
+        {
+            audio_mixer::log_warning("Serial device removed from port: " + path);
+            end_session();
+        }
+    }
 
-            std::string line;
-            std::getline(is, line);
+    void serial_connection_c::set_ports(std::vector<std::string> ports)
+    {
+        m_fixed_ports = std::move(ports);
+    }
 
-            if (line.find(HEARTBEAT) != std::string::npos)
-            {
-                std::string response = HEARTBEAT + "\n";
-                boost::asio::write(m_serial, boost::asio::buffer(response));
-                last_heartbeat = std::chrono::steady_clock::now();
-                audio_mixer::log_debug("Heartbeat received from serial port: " + m_port + " at:" 
-                                       + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
-                                             last_heartbeat.time_since_epoch())
-                                             .count()));
-                disconnected_logged = false; // Reset on heartbeat
-            }
-            else
-            {
-                // remove trailing newline
-                line.erase(line.find_last_not_of("\r\n") + 1); // Removes trailing \r or \n
-                audio_mixer::log_debug("Data received from serial port: " + m_port + " - " + line);
-                m_data_stack->push(line);
-            }
+    std::vector<std::string> serial_connection_c::candidate_ports() const
+    {
+        return m_fixed_ports.empty() ? list_serial_ports() : m_fixed_ports;
+    }
 
-            if (std::chrono::steady_clock::now() - last_heartbeat > std::chrono::milliseconds(HEARTBEAT_TIMEOUT_MS))
+    // Sleep until the hotplug watcher reports new serial ports, or until it is time to
+    // retry the ports that are already there
+    std::vector<std::string> serial_connection_c::wait_for_new_ports(bool &exit_app)
+    {
+        auto const retry = std::chrono::steady_clock::now() + std::chrono::milliseconds(PROBE_RETRY_MS);
+        std::unique_lock<std::mutex> lock(m_session_mutex);
+        while (!exit_app && m_arrived_ports.empty() && !m_rescan)
+        {
+            if (std::chrono::steady_clock::now() >= retry)
             {
-                if (!disconnected_logged)
-                {
-                    audio_mixer::log_warning("Lost heartbeat, serial device disconnected from port: " + m_port);
-                    disconnected_logged = true;
-                }
-                else
-                {
-                    // TODO: Confirming if this check is actually neeeded.
-                    audio_mixer::log_debug("logging disconnection \"disconnected_logged\" required!");
-                }
+                m_rescan = true;
                 break;
             }
+            m_session_cv.wait_for(lock, std::chrono::milliseconds(SESSION_EXIT_CHECK_MS));
         }
-        if (m_serial.is_open())
-        {
-            m_serial.close();
-            audio_mixer::log_error("Serial port closed: " + m_port + (exit_app ? ". Exiting application." : ""));
-        }
+        lock.unlock();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(HOTPLUG_SETTLE_MS));
+
+        lock.lock();
+        std::vector<std::string> ports;
+        ports.swap(m_arrived_ports);
+        bool rescan = m_rescan;
+        m_rescan = false;
+        lock.unlock();
+
+        return rescan ? list_serial_ports() : ports;
     }
 
     // Main run() function: scan, connect, and maintain connection
     void serial_connection_c::run(bool &exit_app)
     {
-        std::string last_connected_port;
+        // Without hotplug support the port list is re-scanned every few seconds instead.
+        bool hotplug = m_fixed_ports.empty() &&
+            m_hotplug.start(DEVICE_DIRECTORY, directory_watcher_c::ENTRIES,
+                [this](std::string const &name, directory_watcher_c::Event event) { handle_device_event(name, event); });
+
+        std::vector<std::string> candidates = candidate_ports();
         while (!exit_app)
         {
-            bool connected = false;
-            for (auto const &port : list_serial_ports())
             {
-                try
-                {
-                    if (m_serial.is_open())
-                        m_serial.close(); // Ensure clean state
-                    audio_mixer::log_debug("Trying to connect to port: " + port);
-                    m_serial.open(port);
-                    m_serial.set_option(m_baud);
-                    m_serial.set_option(boost::asio::serial_port::character_size(8));
-                    m_serial.set_option(boost::asio::serial_port::parity(boost::asio::serial_port::parity::none));
-                    m_serial.set_option(boost::asio::serial_port::stop_bits(boost::asio::serial_port::stop_bits::one));
-                    m_serial.set_option(
-                        boost::asio::serial_port::flow_control(boost::asio::serial_port::flow_control::none));
-                    std::this_thread::sleep_for(std::chrono::seconds(2));
+                std::lock_guard<std::mutex> lock(m_session_mutex);
+                m_arrived_ports.clear(); // Already covered by this probe
+                m_rescan = false;
+            }
 
-                    if (try_connect_and_handshake(m_serial, port))
-                    {
-                        m_port = port;
-                        connected = true;
-                        if (last_connected_port != port)
-                        {
-                            last_connected_port = port;
-                        }
-                        audio_mixer::log_info("Connected to serial port: " + port);
-                        break;
-                    }
-                    m_serial.close();
-                }
-                catch (const std::exception &ex)
+            // Probe every candidate at once, the first handshake wins.
+            auto result = m_prober.probe(candidates, std::chrono::milliseconds(HANDSHAKE_TIMEOUT_MS));
+            if (!result)
+            {
+                m_port.clear(); // Clear current port on disconnect
+                if (hotplug)
                 {
-                    audio_mixer::log_warning("Exception opening port " + port + ": " + ex.what());
-                    if (m_serial.is_open())
-                    {
-                        audio_mixer::log_warning("Failed to connect to port: " + port + ". Closing serial port.");
-                        m_serial.close();
-                    }
+                    candidates = wait_for_new_ports(exit_app);
                 }
-            }
-            if (!connected)
-            {
-                if (!last_connected_port.empty())
+                else
                 {
-                    last_connected_port.clear();
+                    std::this_thread::sleep_for(std::chrono::seconds(2));
+                    candidates = candidate_ports();
                 }
-                m_port.clear(); // Clear current port on disconnect
-                std::this_thread::sleep_for(std::chrono::seconds(2));
                 continue;
             }
 
+            m_serial = std::move(result->serial);
+            m_port = result->port;
+            m_protocol = result->protocol;
+            audio_mixer::log_info("Connected to serial port: " + m_port);
+
             // --- Data/heartbeat phase ---
             main_read_loop(exit_app);
 
             m_port.clear(); // Clear current port after disconnect
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+            candidates = candidate_ports();
         }
     }
 } // namespace audio_mixer
@@ -0,0 +1,189 @@
+#include "serial_prober.hpp"
+
+#include <future>
+#include <istream>
+#include <memory>
+
+#include "logger.hpp"
+
+namespace audio_mixer
+{
+    namespace
+    {
+        // Extra time given to the io_context before a probe is abandoned.
+        constexpr std::chrono::milliseconds PROBE_GRACE_PERIOD(1000);
+
+        struct probe_port
+        {
+            probe_port(boost::asio::io_context &context, std::string const &name)
+                : name(name),
+                  serial(context),
+                  deadline(context),
+                  done(false)
+            {
+            }
+
+            std::string name;
+            boost::asio::serial_port serial;
+            boost::asio::steady_timer deadline;
+            boost::asio::streambuf buffer;
+            bool done;
+        };
+
+        // Shared by every handler of one probe, only touched on the io_context thread.
+        struct probe_state
+        {
+            std::vector<std::unique_ptr<probe_port>> ports;
+            size_t remaining = 0;
+            bool finished = false;
+            std::promise<std::optional<probe_result>> result;
+        };
+
+        void finish_port(std::shared_ptr<probe_state> const &state, probe_port &port)
+        {
+            port.done = true;
+            port.deadline.cancel();
+            boost::system::error_code ec;
+            port.serial.close(ec);
+
+            if (--state->remaining == 0 && !state->finished)
+            {
+                state->finished = true;
+                state->result.set_value(std::nullopt);
+            }
+        }
+
+        void win(std::shared_ptr<probe_state> const &state, probe_port &port, std::string const &line)
+        {
+            // Accept v2 when the device offers it, plain READY keeps older firmware on text.
+            bool binary = line.find(std::string(HANDSHAKE_KEY) + std::string(PROTOCOL_V2)) != std::string::npos;
+            std::string response = std::string(HANDSHAKE_RESPONSE) + (binary ? std::string(PROTOCOL_V2) : "") + "\n";
+
+            boost::system::error_code ec;
+            boost::asio::write(port.serial, boost::asio::buffer(response), ec);
+            if (ec)
+            {
+                audio_mixer::log_warning("Failed to answer handshake on port " + port.name + ": " + ec.message());
+                finish_port(state, port);
+                return;
+            }
+            audio_mixer::log_info("Handshake successful on port: " + port.name +
+                                  (binary ? " (binary protocol v2)" : " (text protocol)"));
+
+            state->finished = true;
+            port.done = true;
+            port.deadline.cancel();
+            for (auto &other : state->ports)
+            {
+                if (!other->done)
+                {
+                    finish_port(state, *other);
+                }
+            }
+            state->result.set_value(probe_result{
+                port.name, binary ? Protocol::BINARY_V2 : Protocol::TEXT, std::move(port.serial)});
+        }
+
+        void read_line(std::shared_ptr<probe_state> state, probe_port &port)
+        {
+            boost::asio::async_read_until(
+                port.serial, port.buffer, '\n',
+                [state, &port](boost::system::error_code const &ec, std::size_t)
+                {
+                    if (state->finished || port.done)
+                    {
+                        return;
+                    }
+                    if (ec)
+                    {
+                        AUDIO_MIXER_LOG_DEBUG("Probe read failed on port ", port.name, ": ", ec.message());
+                        finish_port(state, port);
+                        return;
+                    }
+
+                    std::istream is(&port.buffer);
+                    std::string line;
+                    std::getline(is, line);
+                    if (line.find(HANDSHAKE_KEY) != std::string::npos)
+                    {
+                        AUDIO_MIXER_LOG_DEBUG("Received handshake line: ", line);
+                        win(state, port, line);
+                        return;
+                    }
+
+                    // Boot messages and partial lines are skipped until the deadline.
+                    read_line(state, port);
+                });
+        }
+    } // namespace
+
+    serial_prober_c::serial_prober_c(boost::asio::io_context &context, baud_rate_t const &baud)
+        : m_context(context),
+          m_baud(baud)
+    {
+    }
+
+    std::optional<probe_result> serial_prober_c::probe(
+        std::vector<std::string> const &ports, std::chrono::milliseconds deadline)
+    {
+        auto state = std::make_shared<probe_state>();
+        for (auto const &name : ports)
+        {
+            auto port = std::make_unique<probe_port>(m_context, name);
+            try
+            {
+                AUDIO_MIXER_LOG_DEBUG("Trying to connect to port: ", name);
+                port->serial.open(name);
+                port->serial.set_option(m_baud);
+                port->serial.set_option(boost::asio::serial_port::character_size(8));
+                port->serial.set_option(boost::asio::serial_port::parity(boost::asio::serial_port::parity::none));
+                port->serial.set_option(boost::asio::serial_port::stop_bits(boost::asio::serial_port::stop_bits::one));
+                port->serial.set_option(
+                    boost::asio::serial_port::flow_control(boost::asio::serial_port::flow_control::none));
+            }
+            catch (const std::exception &ex)
+            {
+                audio_mixer::log_warning("Exception opening port " + name + ": " + ex.what());
+                continue;
+            }
+            state->ports.emplace_back(std::move(port));
+        }
+
+        if (state->ports.empty())
+        {
+            return std::nullopt;
+        }
+        state->remaining = state->ports.size();
+        auto future = state->result.get_future();
+
+        // Start every port from the io_context thread so all probe state stays on it.
+        boost::asio::post(m_context,
+            [state, deadline]()
+            {
+                for (auto &port : state->ports)
+                {
+                    probe_port &p = *port;
+                    p.deadline.expires_after(deadline);
+                    p.deadline.async_wait(
+                        [state, &p](boost::system::error_code const &ec)
+                        {
+                            if (ec || state->finished || p.done)
+                            {
+                                return;
+                            }
+                            AUDIO_MIXER_LOG_DEBUG("Handshake timed out on port: ", p.name);
+                            finish_port(state, p);
+                        });
+                    read_line(state, p);
+                }
+            });
+
+        if (future.wait_for(deadline + PROBE_GRACE_PERIOD) != std::future_status::ready)
+        {
+            audio_mixer::log_error("Serial probe did not complete, is the io_context running?");
+            return std::nullopt;
+        }
+        return future.get();
+    }
+
+} // namespace audio_mixer
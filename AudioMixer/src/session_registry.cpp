@@ -0,0 +1,160 @@
+#include "session_registry.hpp"
+
+namespace audio_mixer
+{
+    session_registry_c::session_registry_c(session_source_c &source, std::chrono::milliseconds max_age,
+                                           std::chrono::milliseconds miss_interval)
+        : m_source(source),
+          m_max_age(max_age),
+          m_miss_interval(miss_interval),
+          m_valid(false),
+          m_generation(0),
+          m_refreshes(0),
+          m_name_lookups(0)
+    {
+    }
+
+    std::vector<endpoint> session_registry_c::get_endpoints()
+    {
+        refresh_if_stale(clock::now());
+
+        std::vector<endpoint> endpoints;
+        endpoints.reserve(m_sessions.size());
+        for (auto &session : m_sessions)
+        {
+            float volume = 0.0f;
+            if (!session.volume->get_volume(volume))
+            {
+                m_valid = false; // Session went away, rebuild on the next call
+                continue;
+            }
+            endpoint app(session.name);
+            app.current_volume = volume;
+            app.pid = session.pid;
+            endpoints.emplace_back(app);
+        }
+        return endpoints;
+    }
+
+    ApplyResult session_registry_c::set_volume(std::string const &name, float volume)
+    {
+        auto const now = clock::now();
+        refresh_if_stale(now);
+
+        auto it = m_by_name.find(name);
+        if (it == m_by_name.end() && now - m_refreshed >= m_miss_interval)
+        {
+            // The application may have started since the last rebuild
+            refresh(now);
+            it = m_by_name.find(name);
+        }
+        if (it == m_by_name.end())
+        {
+            return ApplyResult::NOT_FOUND;
+        }
+        return apply(it->second, volume);
+    }
+
+    ApplyResult session_registry_c::set_group_volume(size_t group, float volume)
+    {
+        auto const now = clock::now();
+        refresh_if_stale(now);
+
+        if ((group >= m_by_group.size() || m_by_group[group].empty()) && now - m_refreshed >= m_miss_interval)
+        {
+            refresh(now);
+        }
+        if (group >= m_by_group.size() || m_by_group[group].empty())
+        {
+            return ApplyResult::NOT_FOUND;
+        }
+        return apply(m_by_group[group], volume);
+    }
+
+    void session_registry_c::set_matcher(std::shared_ptr<endpoint_matcher_c const> matcher)
+    {
+        // Groups are resolved with the process names, so both are looked up again
+        m_matcher = std::move(matcher);
+        m_processes.clear();
+        m_valid = false;
+    }
+
+    ApplyResult session_registry_c::apply(std::vector<size_t> const &indexes, float volume)
+    {
+        bool applied = false;
+        for (size_t index : indexes)
+        {
+            if (m_sessions[index].volume->set_volume(volume))
+            {
+                applied = true;
+            }
+            else
+            {
+                m_valid = false;
+            }
+        }
+        return applied ? ApplyResult::APPLIED : ApplyResult::FAILED;
+    }
+
+    void session_registry_c::invalidate()
+    {
+        m_valid = false;
+    }
+
+    void session_registry_c::refresh_if_stale(clock::time_point now)
+    {
+        if (!m_valid || m_source.session_generation() != m_generation || now - m_refreshed >= m_max_age)
+        {
+            refresh(now);
+        }
+    }
+
+    void session_registry_c::refresh(clock::time_point now)
+    {
+        // Read the generation first, a change during the walk triggers another rebuild
+        m_generation = m_source.session_generation();
+        std::vector<audio_session> sessions = m_source.enumerate_sessions();
+
+        std::unordered_map<uint32_t, process> processes;
+        m_sessions.clear();
+        m_by_name.clear();
+        m_by_group.assign(m_matcher ? m_matcher->size() : 0, {});
+        for (auto &session : sessions)
+        {
+            auto known = processes.find(session.pid);
+            if (known == processes.end())
+            {
+                auto cached = m_processes.find(session.pid);
+                if (cached != m_processes.end())
+                {
+                    known = processes.emplace(session.pid, std::move(cached->second)).first;
+                }
+                else
+                {
+                    ++m_name_lookups;
+                    std::string name = m_source.process_name(session.pid);
+                    int const group = m_matcher ? m_matcher->match(name) : endpoint_matcher_c::NO_GROUP;
+                    known = processes.emplace(session.pid, process{std::move(name), group}).first;
+                }
+            }
+            if (known->second.name.empty())
+            {
+                continue;
+            }
+
+            if (known->second.group != endpoint_matcher_c::NO_GROUP)
+            {
+                m_by_group[known->second.group].emplace_back(m_sessions.size());
+            }
+            m_by_name[known->second.name].emplace_back(m_sessions.size());
+            m_sessions.push_back(cached_session{known->second.name, session.pid, std::move(session.volume)});
+        }
+
+        // Pids without a session are dropped, so a reused pid is looked up again
+        m_processes.swap(processes);
+        m_valid = true;
+        m_refreshed = now;
+        ++m_refreshes;
+    }
+
+} // namespace audio_mixer
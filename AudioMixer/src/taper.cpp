@@ -0,0 +1,179 @@
+#include "taper.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include "endpoint.hpp"
+
+namespace audio_mixer
+{
+    namespace
+    {
+        constexpr size_t TABLE10_SIZE = 1024;
+        constexpr size_t TABLE12_SIZE = 4096;
+
+        constexpr double LN2 = 0.69314718055994530942;
+        constexpr double LN10 = 2.30258509299404568402;
+        // Range of the logarithmic taper, the bottom step above zero is -60 dB
+        constexpr double LOG_RANGE_DB = 60.0;
+
+        // exp() for table generation, std::exp is not constexpr.
+        // Reduces to |r| <= ln2 / 2 and sums the Taylor series, good to double precision.
+        constexpr double constexpr_exp(double x)
+        {
+            int k = static_cast<int>(x / LN2 + (x < 0.0 ? -0.5 : 0.5));
+            double const r = x - k * LN2;
+            double term = 1.0;
+            double sum = 1.0;
+            for (int n = 1; n < 16; n++)
+            {
+                term *= r / n;
+                sum += term;
+            }
+            for (; k > 0; k--)
+            {
+                sum *= 2.0;
+            }
+            for (; k < 0; k++)
+            {
+                sum /= 2.0;
+            }
+            return sum;
+        }
+
+        constexpr double curve(Taper taper, double x)
+        {
+            switch (taper)
+            {
+            case Taper::LOGARITHMIC:
+                return x <= 0.0 ? 0.0 : constexpr_exp((x - 1.0) * LOG_RANGE_DB / 20.0 * LN10);
+            case Taper::S_CURVE:
+                return x * x * (3.0 - 2.0 * x);
+            default:
+                return x;
+            }
+        }
+
+        template <size_t SIZE>
+        constexpr std::array<float, SIZE> make_table(Taper taper)
+        {
+            std::array<float, SIZE> table{};
+            for (size_t i = 0; i < SIZE; i++)
+            {
+                table[i] = static_cast<float>(curve(taper, static_cast<double>(i) / (SIZE - 1)));
+            }
+            return table;
+        }
+
+        constexpr std::array<float, TABLE10_SIZE> LINEAR10 = make_table<TABLE10_SIZE>(Taper::LINEAR);
+        constexpr std::array<float, TABLE12_SIZE> LINEAR12 = make_table<TABLE12_SIZE>(Taper::LINEAR);
+        constexpr std::array<float, TABLE10_SIZE> LOG10 = make_table<TABLE10_SIZE>(Taper::LOGARITHMIC);
+        constexpr std::array<float, TABLE12_SIZE> LOG12 = make_table<TABLE12_SIZE>(Taper::LOGARITHMIC);
+        constexpr std::array<float, TABLE10_SIZE> S_CURVE10 = make_table<TABLE10_SIZE>(Taper::S_CURVE);
+        constexpr std::array<float, TABLE12_SIZE> S_CURVE12 = make_table<TABLE12_SIZE>(Taper::S_CURVE);
+
+        static_assert(LINEAR12[TABLE12_SIZE - 1] == 1.0f && LOG12[0] == 0.0f, "taper end points");
+        static_assert(LOG12[TABLE12_SIZE - 1] > 0.9999f && LOG12[TABLE12_SIZE - 1] < 1.0001f, "0 dB at the top");
+
+        // Fill a table from evenly spaced points by linear interpolation
+        void fill_custom(std::vector<float> const &points, float *table, size_t size)
+        {
+            size_t const segments = points.size() - 1;
+            for (size_t i = 0; i < size; i++)
+            {
+                double const position = static_cast<double>(i) * segments / (size - 1);
+                size_t const segment = std::min(static_cast<size_t>(position), segments - 1);
+                double const fraction = position - segment;
+                double const value = points[segment] + (points[segment + 1] - points[segment]) * fraction;
+                table[i] = std::clamp(static_cast<float>(value), 0.0f, 1.0f);
+            }
+        }
+    } // namespace
+
+    bool parse_taper(std::string const &name, Taper &taper)
+    {
+        std::string const lower = toLower(name);
+        if (lower == "linear")
+        {
+            taper = Taper::LINEAR;
+        }
+        else if (lower == "log" || lower == "logarithmic" || lower == "db")
+        {
+            taper = Taper::LOGARITHMIC;
+        }
+        else if (lower == "s-curve" || lower == "s_curve" || lower == "scurve")
+        {
+            taper = Taper::S_CURVE;
+        }
+        else if (lower == "custom")
+        {
+            taper = Taper::CUSTOM;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+    taper_c::taper_c()
+    {
+        set_curve(Taper::LINEAR);
+    }
+
+    void taper_c::set_curve(Taper taper)
+    {
+        m_custom.reset();
+        switch (taper)
+        {
+        case Taper::LOGARITHMIC:
+            m_table10 = LOG10.data();
+            m_table12 = LOG12.data();
+            break;
+        case Taper::S_CURVE:
+            m_table10 = S_CURVE10.data();
+            m_table12 = S_CURVE12.data();
+            break;
+        default:
+            m_table10 = LINEAR10.data();
+            m_table12 = LINEAR12.data();
+            break;
+        }
+    }
+
+    bool taper_c::set_custom(std::vector<float> const &points)
+    {
+        if (points.size() < 2)
+        {
+            return false;
+        }
+        auto tables = std::make_shared<std::vector<float>>(TABLE10_SIZE + TABLE12_SIZE);
+        fill_custom(points, tables->data(), TABLE10_SIZE);
+        fill_custom(points, tables->data() + TABLE10_SIZE, TABLE12_SIZE);
+        m_table10 = tables->data();
+        m_table12 = tables->data() + TABLE10_SIZE;
+        m_custom = std::move(tables);
+        return true;
+    }
+
+    float taper_c::apply(float reading, uint8_t bits) const
+    {
+        if (bits == 12)
+        {
+            return m_table12[std::min(static_cast<size_t>(std::max(reading, 0.0f) + 0.5f), TABLE12_SIZE - 1)];
+        }
+        if (bits == 10)
+        {
+            return m_table10[std::min(static_cast<size_t>(std::max(reading, 0.0f) + 0.5f), TABLE10_SIZE - 1)];
+        }
+
+        // Other resolutions interpolate the 12-bit table
+        float const full_scale = static_cast<float>((uint32_t{1} << bits) - 1);
+        float const position = std::clamp(reading / full_scale, 0.0f, 1.0f) * (TABLE12_SIZE - 1);
+        size_t const index = std::min(static_cast<size_t>(position), TABLE12_SIZE - 2);
+        float const fraction = position - static_cast<float>(index);
+        return m_table12[index] + (m_table12[index + 1] - m_table12[index]) * fraction;
+    }
+
+} // namespace audio_mixer
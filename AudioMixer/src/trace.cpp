@@ -0,0 +1,131 @@
+#include "trace.hpp"
+
+#include <chrono>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "logger.hpp"
+#include "pipeline_latency.hpp"
+
+namespace audio_mixer
+{
+    trace_c::trace_c()
+        : m_records(nullptr),
+          m_capacity(0),
+          m_next(0),
+          m_mapping(nullptr),
+          m_mapping_size(0)
+#ifdef _WIN32
+          ,
+          m_file(INVALID_HANDLE_VALUE),
+          m_mapping_handle(nullptr)
+#endif
+    {
+    }
+
+    bool trace_c::open(std::string const &path, size_t capacity)
+    {
+        close();
+        if (capacity == 0)
+        {
+            return false;
+        }
+
+        // Keep the trace of the previous run, e.g. the one that ended in a crash
+        std::error_code ec;
+        if (std::filesystem::exists(path, ec))
+        {
+            std::filesystem::rename(path, path + ".prev", ec);
+        }
+
+        size_t const size = sizeof(trace_header) + capacity * sizeof(trace_record);
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            audio_mixer::log_error("Cannot create trace file " + path);
+            return false;
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(uint64_t{size} >> 32),
+                                            static_cast<DWORD>(size & 0xFFFFFFFFu), nullptr);
+        void *view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size) : nullptr;
+        if (view == nullptr)
+        {
+            audio_mixer::log_error("Cannot map trace file " + path);
+            if (mapping != nullptr)
+            {
+                CloseHandle(mapping);
+            }
+            CloseHandle(file);
+            return false;
+        }
+        m_file = file;
+        m_mapping_handle = mapping;
+#else
+        int const fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            audio_mixer::log_error("Cannot create trace file " + path);
+            return false;
+        }
+        // Populate up front, so the first pass over the ring does not take page faults
+        void *view = ftruncate(fd, static_cast<off_t>(size)) == 0
+                         ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0)
+                         : MAP_FAILED;
+        ::close(fd); // The mapping keeps the file
+        if (view == MAP_FAILED)
+        {
+            audio_mixer::log_error("Cannot map trace file " + path);
+            return false;
+        }
+#endif
+        m_mapping = view;
+        m_mapping_size = size;
+
+        // A fresh file reads as zeros, i.e. every slot is empty
+        auto *header = static_cast<trace_header *>(view);
+        std::memcpy(header->magic, TRACE_MAGIC, sizeof(header->magic));
+        header->version = TRACE_VERSION;
+        header->record_size = sizeof(trace_record);
+        header->capacity = capacity;
+        header->wall_start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::system_clock::now().time_since_epoch())
+                                    .count();
+        header->steady_start_ns = pipeline_latency_c::now_ns();
+
+        m_capacity = capacity;
+        m_next.store(0, std::memory_order_relaxed);
+        m_records.store(reinterpret_cast<trace_record *>(header + 1), std::memory_order_release);
+        audio_mixer::log_info("Tracing " + std::to_string(capacity) + " records into " + path);
+        return true;
+    }
+
+    void trace_c::close()
+    {
+        if (m_mapping == nullptr)
+        {
+            return;
+        }
+        m_records.store(nullptr, std::memory_order_release);
+#ifdef _WIN32
+        UnmapViewOfFile(m_mapping);
+        CloseHandle(m_mapping_handle);
+        CloseHandle(m_file);
+        m_mapping_handle = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        munmap(m_mapping, m_mapping_size);
+#endif
+        m_mapping = nullptr;
+        m_mapping_size = 0;
+    }
+
+} // namespace audio_mixer
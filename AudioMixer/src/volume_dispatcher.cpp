@@ -0,0 +1,112 @@
+#include "volume_dispatcher.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace audio_mixer
+{
+    volume_dispatcher_c::volume_dispatcher_c()
+        : m_issued(0),
+          m_suppressed(0),
+          m_coalesced(0)
+    {
+        configure(0.0f, 0.0f, std::chrono::milliseconds(0));
+    }
+
+    void volume_dispatcher_c::configure(float step, float dead_band, std::chrono::milliseconds min_interval)
+    {
+        m_step = std::max(step, 0.0f);
+        m_dead_band = std::max(dead_band, 0.0f);
+        m_min_interval = min_interval;
+        m_targets.fill(0.0f);
+        m_applied.fill(-1.0f);
+        m_last_call.fill(clock::time_point{});
+        m_pending = 0;
+    }
+
+    float volume_dispatcher_c::set_target(size_t index, float volume)
+    {
+        float const target = quantize(volume);
+        float const applied = m_applied[index];
+        uint64_t const bit = uint64_t{1} << index;
+        m_targets[index] = target;
+
+        // Always let the knob reach its end stops, even inside the dead-band
+        bool const end_stop = (target == 0.0f || target == 1.0f) && target != applied;
+        if (applied >= 0.0f && std::abs(target - applied) <= m_dead_band && !end_stop)
+        {
+            if (!(m_pending & bit))
+            {
+                ++m_suppressed;
+            }
+            // A held back change that moved back to the applied volume is simply dropped
+            m_pending &= ~bit;
+            return target;
+        }
+
+        if (m_pending & bit)
+        {
+            ++m_coalesced;
+        }
+        m_pending |= bit;
+        return target;
+    }
+
+    uint64_t volume_dispatcher_c::due(clock::time_point now) const
+    {
+        uint64_t due = 0;
+        for (uint64_t pending = m_pending; pending != 0; pending &= pending - 1)
+        {
+            size_t index = 0;
+            while (!(pending & (uint64_t{1} << index)))
+            {
+                ++index;
+            }
+            if (now - m_last_call[index] >= m_min_interval)
+            {
+                due |= uint64_t{1} << index;
+            }
+        }
+        return due;
+    }
+
+    volume_dispatcher_c::clock::time_point volume_dispatcher_c::next_due() const
+    {
+        auto next = clock::time_point::max();
+        for (size_t index = 0; index < AUDIO_MIXER_MAX_KNOBS; index++)
+        {
+            if (m_pending & (uint64_t{1} << index))
+            {
+                next = std::min(next, m_last_call[index] + m_min_interval);
+            }
+        }
+        return next;
+    }
+
+    void volume_dispatcher_c::record_call(size_t index, bool applied, clock::time_point now)
+    {
+        ++m_issued;
+        m_last_call[index] = now;
+        if (applied)
+        {
+            m_applied[index] = m_targets[index];
+        }
+        m_pending &= ~(uint64_t{1} << index);
+    }
+
+    void volume_dispatcher_c::forget(size_t index)
+    {
+        m_applied[index] = -1.0f;
+    }
+
+    float volume_dispatcher_c::quantize(float volume) const
+    {
+        volume = std::clamp(volume, 0.0f, 1.0f);
+        if (m_step <= 0.0f)
+        {
+            return volume;
+        }
+        return std::min(std::round(volume / m_step) * m_step, 1.0f);
+    }
+
+} // namespace audio_mixer
@@ -0,0 +1,150 @@
+#include "volume_ramp.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "endpoint.hpp"
+
+namespace audio_mixer
+{
+    namespace
+    {
+        // An exponential ramp this close to its goal snaps onto it
+        constexpr float EXPONENTIAL_SETTLE = 0.001f;
+    } // namespace
+
+    bool parse_ramp_mode(std::string const &name, RampMode &mode)
+    {
+        std::string const lower = toLower(name);
+        if (lower == "none")
+        {
+            mode = RampMode::NONE;
+        }
+        else if (lower == "linear")
+        {
+            mode = RampMode::LINEAR;
+        }
+        else if (lower == "exponential")
+        {
+            mode = RampMode::EXPONENTIAL;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+    volume_ramp_c::volume_ramp_c()
+    {
+        configure(std::chrono::milliseconds(10));
+    }
+
+    void volume_ramp_c::configure(std::chrono::milliseconds tick)
+    {
+        m_tick = std::max(tick, std::chrono::milliseconds(1));
+        m_next_tick = clock::time_point::max();
+        m_modes.fill(RampMode::NONE);
+        m_times.fill(0.0f);
+        m_goals.fill(0.0f);
+        m_starts.fill(0.0f);
+        m_values.fill(0.0f);
+        m_start_times.fill(clock::time_point{});
+        m_known = 0;
+        m_active = 0;
+        m_updated = 0;
+    }
+
+    void volume_ramp_c::set_mode(size_t index, RampMode mode, std::chrono::milliseconds time)
+    {
+        m_modes[index] = (time.count() > 0) ? mode : RampMode::NONE;
+        m_times[index] = std::chrono::duration<float>(time).count();
+    }
+
+    void volume_ramp_c::set_goal(size_t index, float goal, clock::time_point now)
+    {
+        uint64_t const bit = uint64_t{1} << index;
+        if (m_modes[index] == RampMode::NONE || !(m_known & bit))
+        {
+            m_values[index] = goal;
+            m_goals[index] = goal;
+            m_known |= bit;
+            m_active &= ~bit;
+            m_updated |= bit;
+            return;
+        }
+        if (goal == m_goals[index])
+        {
+            return;
+        }
+
+        // Restart from wherever the running ramp is
+        m_goals[index] = goal;
+        m_starts[index] = m_values[index];
+        m_start_times[index] = now;
+        if (m_active == 0)
+        {
+            m_next_tick = now + m_tick;
+        }
+        m_active |= bit;
+    }
+
+    uint64_t volume_ramp_c::advance(clock::time_point now)
+    {
+        uint64_t updated = m_updated;
+        m_updated = 0;
+        if (m_active == 0 || now < m_next_tick)
+        {
+            return updated;
+        }
+
+        for (size_t index = 0; index < AUDIO_MIXER_MAX_KNOBS; index++)
+        {
+            uint64_t const bit = uint64_t{1} << index;
+            if (!(m_active & bit))
+            {
+                continue;
+            }
+
+            float const elapsed = std::chrono::duration<float>(now - m_start_times[index]).count();
+            float const start = m_starts[index];
+            float const goal = m_goals[index];
+            float value = goal;
+            if (m_modes[index] == RampMode::LINEAR)
+            {
+                float const progress = elapsed / m_times[index];
+                if (progress < 1.0f)
+                {
+                    value = start + (goal - start) * progress;
+                }
+            }
+            else
+            {
+                value = goal + (start - goal) * std::exp(-elapsed / m_times[index]);
+                if (std::abs(goal - value) < EXPONENTIAL_SETTLE)
+                {
+                    value = goal;
+                }
+            }
+
+            if (value == goal)
+            {
+                m_active &= ~bit;
+            }
+            if (value != m_values[index])
+            {
+                m_values[index] = value;
+                updated |= bit;
+            }
+        }
+
+        m_next_tick = (m_active != 0) ? now + m_tick : clock::time_point::max();
+        return updated;
+    }
+
+    volume_ramp_c::clock::time_point volume_ramp_c::next_tick() const
+    {
+        return m_next_tick;
+    }
+
+} // namespace audio_mixer
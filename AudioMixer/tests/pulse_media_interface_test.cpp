@@ -0,0 +1,427 @@
+// Tests for pulse_media_interface_c against a private PulseAudio daemon with null devices.
+//
+// Usage: pulse_media_interface_test <pulseaudio executable>
+//
+// Starts "pulseaudio --daemonize=no -n" with a null sink and a null source on a socket in a
+// temporary directory, plays a silent stream, sets the master, mic and stream volumes through
+// the backend and reads them back from the server with a separate connection. A write the
+// server rejects must come back through take_failed().
+
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "pulse_media_interface.hpp"
+
+namespace
+{
+    using audio_mixer::ApplyResult;
+    using audio_mixer::endpoint;
+    using audio_mixer::volume_change;
+
+    int failures = 0;
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition);                        \
+            failures++;                                                                                                \
+        }                                                                                                              \
+    } while (0)
+
+    constexpr char const *PLAYER_NAME = "audiomixer-test-player";
+    constexpr auto TIMEOUT = std::chrono::seconds(10);
+
+    // Poll until the condition holds or the timeout passed
+    template <typename condition_t>
+    bool wait_until(condition_t condition)
+    {
+        auto const deadline = std::chrono::steady_clock::now() + TIMEOUT;
+        while (!condition())
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return true;
+    }
+
+    // pulseaudio in the foreground, without the default script and with its socket in directory
+    pid_t start_daemon(std::string const &executable, std::string const &directory)
+    {
+        std::string const socket = directory + "/native";
+        pid_t const pid = fork();
+        if (pid == 0)
+        {
+            setenv("XDG_RUNTIME_DIR", directory.c_str(), 1);
+            setenv("HOME", directory.c_str(), 1);
+            std::string const protocol = "--load=module-native-protocol-unix socket=" + socket + " auth-anonymous=1";
+            execl(executable.c_str(), executable.c_str(), "--daemonize=no", "-n", "--use-pid-file=no",
+                  "--exit-idle-time=-1", "--disable-shm=yes", "--log-target=stderr", protocol.c_str(),
+                  "--load=module-null-sink sink_name=test_sink", "--load=module-null-source source_name=test_source",
+                  static_cast<char *>(nullptr));
+            std::perror("execl");
+            _exit(127);
+        }
+        if (pid < 0)
+        {
+            return -1;
+        }
+        // Stop waiting early if the daemon exits, e.g. because a module failed to load
+        bool exited = false;
+        bool const listening = wait_until([&]() {
+            exited = waitpid(pid, nullptr, WNOHANG) == pid;
+            return exited || std::filesystem::exists(socket);
+        });
+        if (!listening || exited)
+        {
+            if (!exited)
+            {
+                kill(pid, SIGTERM);
+                waitpid(pid, nullptr, 0);
+            }
+            return -1;
+        }
+        return pid;
+    }
+
+    // A second client that plays silence and reads volumes back
+    class pulse_client_c
+    {
+    public:
+        pulse_client_c()
+            : m_mainloop(pa_threaded_mainloop_new()),
+              m_context(nullptr),
+              m_stream(nullptr)
+        {
+            pa_proplist *properties = pa_proplist_new();
+            pa_proplist_sets(properties, PA_PROP_APPLICATION_NAME, PLAYER_NAME);
+            m_context = pa_context_new_with_proplist(pa_threaded_mainloop_get_api(m_mainloop), PLAYER_NAME, properties);
+            pa_proplist_free(properties);
+            pa_context_set_state_callback(m_context, on_signal, m_mainloop);
+            pa_threaded_mainloop_start(m_mainloop);
+        }
+
+        ~pulse_client_c()
+        {
+            pa_threaded_mainloop_lock(m_mainloop);
+            if (m_stream)
+            {
+                pa_stream_disconnect(m_stream);
+                pa_stream_unref(m_stream);
+            }
+            pa_context_disconnect(m_context);
+            pa_context_unref(m_context);
+            pa_threaded_mainloop_unlock(m_mainloop);
+            pa_threaded_mainloop_stop(m_mainloop);
+            pa_threaded_mainloop_free(m_mainloop);
+        }
+
+        bool connect()
+        {
+            pa_threaded_mainloop_lock(m_mainloop);
+            bool ready = pa_context_connect(m_context, nullptr, PA_CONTEXT_NOAUTOSPAWN, nullptr) >= 0;
+            while (ready && pa_context_get_state(m_context) != PA_CONTEXT_READY)
+            {
+                ready = PA_CONTEXT_IS_GOOD(pa_context_get_state(m_context));
+                if (ready)
+                {
+                    pa_threaded_mainloop_wait(m_mainloop);
+                }
+            }
+            pa_threaded_mainloop_unlock(m_mainloop);
+            return ready;
+        }
+
+        // A playback stream on the default sink, silent because nothing is written
+        bool play()
+        {
+            pa_sample_spec const spec = {PA_SAMPLE_S16LE, 44100, 2};
+            pa_threaded_mainloop_lock(m_mainloop);
+            m_stream = pa_stream_new(m_context, "silence", &spec, nullptr);
+            pa_stream_set_state_callback(m_stream, on_stream_signal, m_mainloop);
+            bool ready = pa_stream_connect_playback(m_stream, nullptr, nullptr, PA_STREAM_NOFLAGS, nullptr, nullptr) >= 0;
+            while (ready && pa_stream_get_state(m_stream) != PA_STREAM_READY)
+            {
+                ready = PA_STREAM_IS_GOOD(pa_stream_get_state(m_stream));
+                if (ready)
+                {
+                    pa_threaded_mainloop_wait(m_mainloop);
+                }
+            }
+            pa_threaded_mainloop_unlock(m_mainloop);
+            return ready;
+        }
+
+        // Ends the playback stream, returns once the server removed it
+        void stop()
+        {
+            uint32_t const index = stream_index();
+            pa_threaded_mainloop_lock(m_mainloop);
+            pa_stream_disconnect(m_stream);
+            pa_stream_unref(m_stream);
+            m_stream = nullptr;
+            pa_threaded_mainloop_unlock(m_mainloop);
+            wait_until([&]() { return !sink_input(index).valid; });
+        }
+
+        uint32_t stream_index()
+        {
+            pa_threaded_mainloop_lock(m_mainloop);
+            uint32_t const index = pa_stream_get_index(m_stream);
+            pa_threaded_mainloop_unlock(m_mainloop);
+            return index;
+        }
+
+        struct reading
+        {
+            pa_volume_t volume = PA_VOLUME_MUTED;
+            bool muted = false;
+            bool valid = false;
+        };
+
+        reading default_sink()
+        {
+            return query([this](pending_query *pending) {
+                return pa_context_get_sink_info_by_name(m_context, "@DEFAULT_SINK@", on_device<pa_sink_info>, pending);
+            });
+        }
+
+        reading default_source()
+        {
+            return query([this](pending_query *pending) {
+                return pa_context_get_source_info_by_name(m_context, "@DEFAULT_SOURCE@", on_device<pa_source_info>,
+                                                          pending);
+            });
+        }
+
+        reading sink_input(uint32_t index)
+        {
+            return query([this, index](pending_query *pending) {
+                return pa_context_get_sink_input_info(m_context, index, on_device<pa_sink_input_info>, pending);
+            });
+        }
+
+    private:
+        struct pending_query
+        {
+            pa_threaded_mainloop *mainloop;
+            reading out;
+        };
+
+        template <typename request_t>
+        reading query(request_t request)
+        {
+            pending_query pending{m_mainloop, reading()};
+            pa_threaded_mainloop_lock(m_mainloop);
+            pa_operation *op = request(&pending);
+            while (op && pa_operation_get_state(op) == PA_OPERATION_RUNNING)
+            {
+                pa_threaded_mainloop_wait(m_mainloop);
+            }
+            if (op)
+            {
+                pa_operation_unref(op);
+            }
+            pa_threaded_mainloop_unlock(m_mainloop);
+            return pending.out;
+        }
+
+        template <typename info_t>
+        static void on_device(pa_context *, info_t const *info, int eol, void *userdata)
+        {
+            auto *pending = static_cast<pending_query *>(userdata);
+            if (eol == 0 && info)
+            {
+                pending->out.volume = pa_cvolume_avg(&info->volume);
+                pending->out.muted = info->mute != 0;
+                pending->out.valid = true;
+            }
+            pa_threaded_mainloop_signal(pending->mainloop, 0);
+        }
+
+        static void on_signal(pa_context *, void *userdata)
+        {
+            pa_threaded_mainloop_signal(static_cast<pa_threaded_mainloop *>(userdata), 0);
+        }
+
+        static void on_stream_signal(pa_stream *, void *userdata)
+        {
+            pa_threaded_mainloop_signal(static_cast<pa_threaded_mainloop *>(userdata), 0);
+        }
+
+        pa_threaded_mainloop *m_mainloop;
+        pa_context *m_context;
+        pa_stream *m_stream;
+    };
+
+    bool near(pa_volume_t actual, float expected)
+    {
+        return std::abs(static_cast<double>(actual) - expected * PA_VOLUME_NORM) <= 1.0;
+    }
+
+    // The backend applies asynchronously, wait for the server to report the volume
+    template <typename read_t>
+    bool reaches(read_t read, float expected, bool muted)
+    {
+        return wait_until([&]() {
+            auto const value = read();
+            return value.valid && near(value.volume, expected) && value.muted == muted;
+        });
+    }
+
+    std::vector<ApplyResult> apply(audio_mixer::pulse_media_interface_c &backend, std::vector<endpoint> const &targets,
+                                   std::vector<float> const &volumes)
+    {
+        std::vector<volume_change> changes;
+        for (size_t i = 0; i < targets.size(); i++)
+        {
+            changes.push_back({&targets[i], i, volumes[i]});
+        }
+        return backend.set_volumes(changes);
+    }
+
+    void test_volumes(pulse_client_c &client)
+    {
+        uint32_t const stream = client.stream_index();
+        audio_mixer::pulse_media_interface_c backend;
+        std::vector<endpoint> const targets = {endpoint("master"), endpoint("mic"), endpoint(PLAYER_NAME)};
+
+        // Connecting and mirroring the devices and streams is asynchronous
+        bool const ready = wait_until([&]() {
+            auto const results = apply(backend, targets, {1.0f, 1.0f, 1.0f});
+            return results[0] == ApplyResult::APPLIED && results[1] == ApplyResult::APPLIED &&
+                   results[2] == ApplyResult::APPLIED;
+        });
+        CHECK(ready);
+        if (!ready)
+        {
+            return;
+        }
+
+        auto const results = apply(backend, targets, {0.25f, 0.5f, 0.75f});
+        CHECK(results[0] == ApplyResult::APPLIED && results[1] == ApplyResult::APPLIED &&
+              results[2] == ApplyResult::APPLIED);
+        CHECK(reaches([&]() { return client.default_sink(); }, 0.25f, false));
+        CHECK(reaches([&]() { return client.default_source(); }, 0.5f, false));
+        CHECK(reaches([&]() { return client.sink_input(stream); }, 0.75f, false));
+
+        // The stream shows up with the volume the server reported
+        CHECK(wait_until([&]() {
+            for (auto const &app : backend.get_endpoints())
+            {
+                if (app.name == PLAYER_NAME && std::abs(app.current_volume - 0.75f) < 0.001f)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }));
+
+        // Zero mutes the microphone and the stream, turning them back up unmutes them
+        apply(backend, targets, {0.25f, 0.0f, 0.0f});
+        CHECK(reaches([&]() { return client.default_source(); }, 0.0f, true));
+        CHECK(reaches([&]() { return client.sink_input(stream); }, 0.0f, true));
+        apply(backend, targets, {0.25f, 0.5f, 0.5f});
+        CHECK(reaches([&]() { return client.default_source(); }, 0.5f, false));
+        CHECK(reaches([&]() { return client.sink_input(stream); }, 0.5f, false));
+
+        // Master is set through the device, not the streams on it
+        backend.set_master_volume(0.125f);
+        CHECK(reaches([&]() { return client.default_sink(); }, 0.125f, false));
+        CHECK(reaches([&]() { return client.sink_input(stream); }, 0.5f, false));
+
+        // Every write above was accepted
+        CHECK(backend.take_failed() == 0);
+    }
+
+    void test_group_volume(pulse_client_c &client)
+    {
+        uint32_t const stream = client.stream_index();
+        audio_mixer::pulse_media_interface_c backend;
+
+        endpoint players("players");
+        players.applications = {"/audiomixer-test-.*/"};
+        std::vector<endpoint> const targets = {endpoint("master"), players};
+        backend.set_matcher(std::make_shared<audio_mixer::endpoint_matcher_c const>(targets));
+
+        // Index 1 is a group, the stream is matched by its application name pattern
+        std::vector<volume_change> const changes = {{&targets[1], 1, 0.375f}};
+        CHECK(wait_until([&]() { return backend.set_volumes(changes)[0] == ApplyResult::APPLIED; }));
+        CHECK(reaches([&]() { return client.sink_input(stream); }, 0.375f, false));
+    }
+
+    // A write to a stream the server already removed is reported, never silently applied
+    void test_rejected_write(pulse_client_c &client)
+    {
+        audio_mixer::pulse_media_interface_c backend;
+        std::vector<endpoint> const targets = {endpoint("master"), endpoint(PLAYER_NAME)};
+        CHECK(wait_until([&]() { return apply(backend, targets, {0.5f, 0.5f})[1] == ApplyResult::APPLIED; }));
+
+        // The backend may or may not have heard of the removal yet
+        client.stop();
+        ApplyResult const result = apply(backend, targets, {0.5f, 0.25f})[1];
+        CHECK(result == ApplyResult::NOT_FOUND ||
+              (result == ApplyResult::APPLIED && wait_until([&]() { return (backend.take_failed() & 2) != 0; })));
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        std::fprintf(stderr, "usage: %s <pulseaudio executable>\n", argv[0]);
+        return 2;
+    }
+
+    char directory_template[] = "/tmp/audiomixer_pulse_XXXXXX";
+    std::string const directory = mkdtemp(directory_template) ? directory_template : "";
+    pid_t const daemon = directory.empty() ? -1 : start_daemon(argv[1], directory);
+    if (daemon < 0)
+    {
+        std::fprintf(stderr, "cannot start %s\n", argv[1]);
+        return 1;
+    }
+
+    // Both the backend and the test client connect to the private daemon only
+    setenv("PULSE_SERVER", ("unix:" + directory + "/native").c_str(), 1);
+    setenv("PULSE_RUNTIME_PATH", directory.c_str(), 1);
+    {
+        pulse_client_c client;
+        bool const connected = client.connect() && client.play();
+        CHECK(connected);
+        if (connected)
+        {
+            test_volumes(client);
+            test_group_volume(client);
+            test_rejected_write(client);
+        }
+    }
+
+    kill(daemon, SIGTERM);
+    waitpid(daemon, nullptr, 0);
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+
+    if (failures != 0)
+    {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("pulse_media_interface_test passed\n");
+    return 0;
+}
@@ -0,0 +1,215 @@
+// Tests for session_registry_c against a session source that counts its calls.
+//
+// Usage: session_registry_test
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "session_registry.hpp"
+
+namespace
+{
+    using audio_mixer::ApplyResult;
+    using audio_mixer::session_registry_c;
+
+    int failures = 0;
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition);                        \
+            failures++;                                                                                                \
+        }                                                                                                              \
+    } while (0)
+
+    class fake_volume_c : public audio_mixer::session_volume_c
+    {
+    public:
+        bool set_volume(float volume) override
+        {
+            m_volume = volume;
+            return m_alive;
+        }
+
+        bool get_volume(float &volume) override
+        {
+            volume = m_volume;
+            return m_alive;
+        }
+
+        float m_volume = 1.0f;
+        bool m_alive = true;
+    };
+
+    // Sessions by pid, counts every call the registry makes
+    class counting_source_c : public audio_mixer::session_source_c
+    {
+    public:
+        std::vector<audio_mixer::audio_session> enumerate_sessions() override
+        {
+            enumerations++;
+            std::vector<audio_mixer::audio_session> sessions;
+            for (auto const &entry : volumes)
+            {
+                sessions.push_back({entry.first, entry.second});
+            }
+            return sessions;
+        }
+
+        std::string process_name(uint32_t pid) override
+        {
+            name_lookups[pid]++;
+            auto const found = names.find(pid);
+            return found != names.end() ? found->second : std::string();
+        }
+
+        uint64_t session_generation() const override { return generation; }
+
+        std::shared_ptr<fake_volume_c> add(uint32_t pid, std::string const &name)
+        {
+            auto volume = std::make_shared<fake_volume_c>();
+            volumes.emplace(pid, volume);
+            names[pid] = name;
+            generation++;
+            return volume;
+        }
+
+        std::multimap<uint32_t, std::shared_ptr<fake_volume_c>> volumes;
+        std::map<uint32_t, std::string> names;
+        std::map<uint32_t, int> name_lookups;
+        uint64_t generation = 0;
+        int enumerations = 0;
+    };
+
+    constexpr auto MAX_AGE = std::chrono::seconds(60);
+    constexpr auto MISS_INTERVAL = std::chrono::milliseconds(100);
+
+    // Cached lookups neither enumerate nor resolve names again
+    void test_lookups_are_cached()
+    {
+        counting_source_c source;
+        auto chrome = source.add(10, "chrome.exe");
+        source.add(10, "chrome.exe"); // A second session of the same process
+        auto spotify = source.add(20, "Spotify.exe");
+        session_registry_c registry(source, MAX_AGE, MISS_INTERVAL);
+
+        for (int i = 0; i < 100; i++)
+        {
+            CHECK(registry.set_volume("CHROME.EXE", 0.5f) == ApplyResult::APPLIED);
+            CHECK(registry.set_volume("spotify.exe", 0.25f) == ApplyResult::APPLIED);
+        }
+        CHECK(registry.get_endpoints().size() == 3);
+        CHECK(source.enumerations == 1);
+        CHECK(source.name_lookups[10] == 1);
+        CHECK(source.name_lookups[20] == 1);
+        CHECK(chrome->m_volume == 0.5f);
+        CHECK(spotify->m_volume == 0.25f);
+    }
+
+    // A new session rebuilds the list, but only the new pid is resolved
+    void test_generation_change_resolves_new_pids_only()
+    {
+        counting_source_c source;
+        source.add(10, "chrome.exe");
+        session_registry_c registry(source, MAX_AGE, MISS_INTERVAL);
+        CHECK(registry.set_volume("chrome.exe", 0.5f) == ApplyResult::APPLIED);
+
+        source.add(30, "discord.exe");
+        CHECK(registry.set_volume("discord.exe", 0.5f) == ApplyResult::APPLIED);
+        CHECK(registry.set_volume("chrome.exe", 0.5f) == ApplyResult::APPLIED);
+        CHECK(source.enumerations == 2);
+        CHECK(source.name_lookups[10] == 1);
+        CHECK(source.name_lookups[30] == 1);
+        CHECK(registry.refresh_count() == 2);
+        CHECK(registry.name_lookup_count() == 2);
+    }
+
+    // Unknown names rebuild at most once per miss interval
+    void test_misses_are_rate_limited()
+    {
+        counting_source_c source;
+        source.add(10, "chrome.exe");
+        session_registry_c registry(source, MAX_AGE, MISS_INTERVAL);
+
+        for (int i = 0; i < 100; i++)
+        {
+            CHECK(registry.set_volume("game.exe", 0.5f) == ApplyResult::NOT_FOUND);
+        }
+        CHECK(source.enumerations == 1);
+
+        std::this_thread::sleep_for(MISS_INTERVAL + std::chrono::milliseconds(20));
+        for (int i = 0; i < 100; i++)
+        {
+            CHECK(registry.set_volume("game.exe", 0.5f) == ApplyResult::NOT_FOUND);
+        }
+        CHECK(source.enumerations == 2);
+        CHECK(source.name_lookups[10] == 1);
+    }
+
+    // A failed handle rebuilds on the next call
+    void test_failed_handle_rebuilds()
+    {
+        counting_source_c source;
+        auto chrome = source.add(10, "chrome.exe");
+        session_registry_c registry(source, MAX_AGE, MISS_INTERVAL);
+        CHECK(registry.set_volume("chrome.exe", 0.5f) == ApplyResult::APPLIED);
+
+        chrome->m_alive = false;
+        CHECK(registry.set_volume("chrome.exe", 0.5f) == ApplyResult::FAILED);
+        CHECK(source.enumerations == 1);
+        CHECK(registry.set_volume("chrome.exe", 0.5f) == ApplyResult::FAILED);
+        CHECK(source.enumerations == 2);
+        CHECK(source.name_lookups[10] == 1);
+    }
+
+    // Groups resolve patterns once per pid, a new matcher resolves them again
+    void test_groups_match_once_per_pid()
+    {
+        counting_source_c source;
+        source.add(10, "chrome.exe");
+        source.add(20, "firefox.exe");
+        session_registry_c registry(source, MAX_AGE, MISS_INTERVAL);
+
+        audio_mixer::endpoint browsers("browsers");
+        browsers.applications = {"chrome.exe", "/fire.*/"};
+        std::vector<audio_mixer::endpoint> endpoints = {audio_mixer::endpoint("master"), browsers};
+        registry.set_matcher(std::make_shared<audio_mixer::endpoint_matcher_c const>(endpoints));
+
+        for (int i = 0; i < 100; i++)
+        {
+            CHECK(registry.set_group_volume(1, 0.5f) == ApplyResult::APPLIED);
+        }
+        CHECK(source.enumerations == 1);
+        CHECK(source.name_lookups[10] == 1);
+        CHECK(source.name_lookups[20] == 1);
+
+        registry.set_matcher(std::make_shared<audio_mixer::endpoint_matcher_c const>(endpoints));
+        CHECK(registry.set_group_volume(1, 0.5f) == ApplyResult::APPLIED);
+        CHECK(source.enumerations == 2);
+        CHECK(source.name_lookups[10] == 2);
+    }
+} // namespace
+
+int main()
+{
+    test_lookups_are_cached();
+    test_generation_change_resolves_new_pids_only();
+    test_misses_are_rate_limited();
+    test_failed_handle_rebuilds();
+    test_groups_match_once_per_pid();
+
+    if (failures != 0)
+    {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("session_registry_test passed\n");
+    return 0;
+}
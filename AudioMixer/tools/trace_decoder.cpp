@@ -0,0 +1,339 @@
+// Offline decoder for the binary trace written by trace_c.
+//
+// Usage: trace_decoder <trace file> [--summary] [--type NAME] [--endpoint N] [--failed] [--last N]
+//
+//   --summary     Print counts, frame rate and timing percentiles instead of the records
+//   --type NAME   Only frame, discard, heartbeat, connect, disconnect or apply records
+//   --endpoint N  Only applications to endpoint N (implies --type apply)
+//   --failed      Only applications the backend did not apply (implies --type apply)
+//   --last N      Only the newest N records that pass the filters
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "trace.hpp"
+
+namespace
+{
+    using audio_mixer::TraceEvent;
+    using audio_mixer::trace_header;
+    using audio_mixer::trace_record;
+
+    constexpr char const *EVENT_NAMES[] = {"none", "frame", "discard", "heartbeat", "connect", "disconnect", "apply"};
+    static_assert(std::size(EVENT_NAMES) == static_cast<size_t>(TraceEvent::COUNT), "a name per trace event");
+
+    // ApplyResult values
+    constexpr char const *RESULT_NAMES[] = {"applied", "not-found", "failed"};
+
+    struct options
+    {
+        std::string path;
+        bool summary = false;
+        int type = -1;
+        int endpoint = -1;
+        bool failed = false;
+        size_t last = 0;
+    };
+
+    struct trace
+    {
+        trace_header header;
+        std::vector<trace_record> records; // Oldest first
+        size_t torn = 0;                   // Slots caught in the middle of a write
+    };
+
+    char const *event_name(TraceEvent type)
+    {
+        size_t const index = static_cast<size_t>(type);
+        return index < std::size(EVENT_NAMES) ? EVENT_NAMES[index] : "unknown";
+    }
+
+    char const *result_name(uint8_t result)
+    {
+        return result < std::size(RESULT_NAMES) ? RESULT_NAMES[result] : "unknown";
+    }
+
+    bool parse_options(int argc, char **argv, options &opts)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string const arg = argv[i];
+            bool const has_value = i + 1 < argc;
+            if (arg == "--summary")
+            {
+                opts.summary = true;
+            }
+            else if (arg == "--failed")
+            {
+                opts.failed = true;
+                opts.type = static_cast<int>(TraceEvent::APPLY);
+            }
+            else if (arg == "--type" && has_value)
+            {
+                std::string const name = argv[++i];
+                auto const found = std::find_if(std::begin(EVENT_NAMES), std::end(EVENT_NAMES),
+                                                [&](char const *candidate) { return name == candidate; });
+                if (found == std::end(EVENT_NAMES))
+                {
+                    std::fprintf(stderr, "unknown event type: %s\n", name.c_str());
+                    return false;
+                }
+                opts.type = static_cast<int>(found - std::begin(EVENT_NAMES));
+            }
+            else if (arg == "--endpoint" && has_value)
+            {
+                opts.endpoint = std::atoi(argv[++i]);
+                opts.type = static_cast<int>(TraceEvent::APPLY);
+            }
+            else if (arg == "--last" && has_value)
+            {
+                opts.last = std::strtoul(argv[++i], nullptr, 10);
+            }
+            else if (arg[0] != '-' && opts.path.empty())
+            {
+                opts.path = arg;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return !opts.path.empty();
+    }
+
+    bool load(std::string const &path, trace &out)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (data.size() < sizeof(trace_header))
+        {
+            std::fprintf(stderr, "%s: not a trace file\n", path.c_str());
+            return false;
+        }
+        std::memcpy(&out.header, data.data(), sizeof(trace_header));
+        auto const &header = out.header;
+        if (std::memcmp(header.magic, audio_mixer::TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != audio_mixer::TRACE_VERSION || header.record_size != sizeof(trace_record) ||
+            header.capacity == 0)
+        {
+            std::fprintf(stderr, "%s: not a trace file or an unsupported version\n", path.c_str());
+            return false;
+        }
+        size_t const available = (data.size() - sizeof(trace_header)) / sizeof(trace_record);
+        size_t const capacity = static_cast<size_t>(std::min<uint64_t>(header.capacity, available));
+
+        for (size_t slot = 0; slot < capacity; slot++)
+        {
+            trace_record record;
+            std::memcpy(&record, data.data() + sizeof(trace_header) + slot * sizeof(trace_record), sizeof(record));
+            if (record.sequence == 0)
+            {
+                // Never written, or torn if the writer had passed this slot
+                out.torn += record.type != TraceEvent::NONE ? 1 : 0;
+                continue;
+            }
+            if ((record.sequence - 1) % header.capacity != slot)
+            {
+                out.torn++;
+                continue;
+            }
+            out.records.push_back(record);
+        }
+        std::sort(out.records.begin(), out.records.end(),
+                  [](trace_record const &a, trace_record const &b) { return a.sequence < b.sequence; });
+        return true;
+    }
+
+    bool matches(trace_record const &record, options const &opts)
+    {
+        if (opts.type >= 0 && static_cast<int>(record.type) != opts.type)
+        {
+            return false;
+        }
+        if (opts.endpoint >= 0 && record.endpoint != opts.endpoint)
+        {
+            return false;
+        }
+        return !opts.failed || record.result != 0;
+    }
+
+    // Local wall clock time of a record, with microseconds
+    std::string wall_time(trace_header const &header, uint64_t time_ns)
+    {
+        int64_t const wall_ns = header.wall_start_ns + static_cast<int64_t>(time_ns - header.steady_start_ns);
+        std::time_t const seconds = static_cast<std::time_t>(wall_ns / 1000000000);
+        std::tm tm_buf;
+#ifdef _WIN32
+        localtime_s(&tm_buf, &seconds);
+#else
+        localtime_r(&seconds, &tm_buf);
+#endif
+        char text[48];
+        size_t const length = std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &tm_buf);
+        std::snprintf(text + length, sizeof(text) - length, ".%06" PRId64, (wall_ns % 1000000000) / 1000);
+        return text;
+    }
+
+    void dump(trace const &input, std::vector<trace_record const *> const &records)
+    {
+        for (auto const *record : records)
+        {
+            std::printf("%s  %-10s", wall_time(input.header, record->time_ns).c_str(), event_name(record->type));
+            switch (record->type)
+            {
+            case TraceEvent::FRAME:
+                std::printf("  parse %6.1f us  knobs %2u:", record->duration_ns / 1000.0,
+                            static_cast<unsigned>(record->count));
+                for (size_t k = 0; k < std::min<size_t>(record->count, audio_mixer::TRACE_KNOBS); k++)
+                {
+                    std::printf(" %u", static_cast<unsigned>(record->values[k]));
+                }
+                if (record->count > audio_mixer::TRACE_KNOBS)
+                {
+                    std::printf(" ...");
+                }
+                break;
+            case TraceEvent::APPLY:
+                std::printf("  endpoint %2u  %-9s  %8.1f us", static_cast<unsigned>(record->endpoint),
+                            result_name(record->result), record->duration_ns / 1000.0);
+                break;
+            default:
+                break;
+            }
+            std::printf("\n");
+        }
+    }
+
+    // p50 / p99 / max of durations in microseconds
+    void print_percentiles(char const *label, std::vector<uint64_t> values)
+    {
+        if (values.empty())
+        {
+            return;
+        }
+        std::sort(values.begin(), values.end());
+        std::printf("  %-22s p50 %9.1f us  p99 %9.1f us  max %9.1f us\n", label, values[values.size() / 2] / 1000.0,
+                    values[values.size() * 99 / 100] / 1000.0, values.back() / 1000.0);
+    }
+
+    void summarize(trace const &input, std::vector<trace_record const *> const &records)
+    {
+        std::printf("capacity %" PRIu64 " records, %zu valid, %zu torn\n", input.header.capacity,
+                    input.records.size(), input.torn);
+        if (records.empty())
+        {
+            std::printf("no matching records\n");
+            return;
+        }
+        double const span_s = (records.back()->time_ns - records.front()->time_ns) / 1e9;
+        std::printf("%zu records from %s to %s (%.3f s)\n", records.size(),
+                    wall_time(input.header, records.front()->time_ns).c_str(),
+                    wall_time(input.header, records.back()->time_ns).c_str(), span_s);
+
+        std::vector<size_t> counts(static_cast<size_t>(TraceEvent::COUNT), 0);
+        std::vector<uint64_t> gaps;
+        std::vector<uint64_t> parses;
+        std::map<uint8_t, std::vector<uint64_t>> apply_times;
+        std::map<uint8_t, std::vector<size_t>> apply_results;
+        uint64_t last_frame = 0;
+        for (auto const *record : records)
+        {
+            size_t const type = static_cast<size_t>(record->type);
+            if (type < counts.size())
+            {
+                counts[type]++;
+            }
+            if (record->type == TraceEvent::FRAME)
+            {
+                if (last_frame != 0 && record->time_ns > last_frame)
+                {
+                    gaps.push_back(record->time_ns - last_frame);
+                }
+                last_frame = record->time_ns;
+                parses.push_back(record->duration_ns);
+            }
+            else if (record->type == TraceEvent::APPLY)
+            {
+                apply_times[record->endpoint].push_back(record->duration_ns);
+                auto &results = apply_results[record->endpoint];
+                results.resize(std::size(RESULT_NAMES), 0);
+                if (record->result < results.size())
+                {
+                    results[record->result]++;
+                }
+            }
+        }
+
+        for (size_t type = 1; type < counts.size(); type++)
+        {
+            if (counts[type] != 0)
+            {
+                std::printf("  %-10s %10zu\n", EVENT_NAMES[type], counts[type]);
+            }
+        }
+        size_t const frames = counts[static_cast<size_t>(TraceEvent::FRAME)];
+        if (frames > 1 && span_s > 0.0)
+        {
+            std::printf("frames: %.1f Hz\n", frames / span_s);
+            print_percentiles("gap between frames", gaps);
+            print_percentiles("parse", parses);
+        }
+        for (auto const &entry : apply_times)
+        {
+            auto const &results = apply_results[entry.first];
+            std::printf("endpoint %u: %zu applied, %zu not found, %zu failed\n", static_cast<unsigned>(entry.first),
+                        results[0], results[1], results[2]);
+            print_percentiles("backend call", entry.second);
+        }
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    options opts;
+    if (!parse_options(argc, argv, opts))
+    {
+        std::fprintf(stderr, "usage: %s <trace file> [--summary] [--type NAME] [--endpoint N] [--failed] [--last N]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    trace input;
+    if (!load(opts.path, input))
+    {
+        return 1;
+    }
+
+    std::vector<trace_record const *> selected;
+    for (auto const &record : input.records)
+    {
+        if (matches(record, opts))
+        {
+            selected.push_back(&record);
+        }
+    }
+    if (opts.last != 0 && selected.size() > opts.last)
+    {
+        selected.erase(selected.begin(), selected.end() - static_cast<std::ptrdiff_t>(opts.last));
+    }
+
+    if (opts.summary)
+    {
+        summarize(input, selected);
+    }
+    else
+    {
+        dump(input, selected);
+    }
+    return 0;
+}